@@ -5,6 +5,9 @@
 #include "common.h"
 #include "value/value.h"
 
+// the slot hint operand of OP_INVOKE before the VM has looked the method up, or when its slot does not fit
+#define INVOKE_NO_HINT UINT8_MAX
+
 typedef enum {
     OP_CONSTANT,          // 2 bytes OP [constant_offset](1 byte )
     OP_CONSTANT_LONG,     // 3 bytes OP [constant_offset](2 bytes)
@@ -32,6 +35,17 @@ typedef enum {
     OP_JUMP,              // jump forward
     OP_LOOP,              // jump back
     OP_CALL,
+    OP_TAIL_CALL,         // a call whose result is returned right away, the callee takes over the caller's frame
+
+    // intrinsics, 1 byte: a call to a builtin native, which runs straight on the arguments on the stack
+    OP_SQRT,
+    OP_FLOOR,
+    OP_ABS,
+    OP_MIN,
+    OP_MAX,
+    OP_POW,
+    OP_LEN,
+    OP_TYPE,
     OP_CLOSURE,
     OP_CLOSURE_UPVALUE,
     OP_RETURN,            // 1 byte  OP
@@ -44,8 +58,6 @@ typedef enum {
     OP_GET_GLOBAL_LONG,
     OP_SET_GLOBAL,
     OP_SET_GLOBAL_LONG,
-    OP_DEFINE_LOCAL,
-    OP_DEFINE_MUT_LOCAL,
     OP_SET_LOCAL,
     OP_GET_LOCAL,
     OP_GET_SUPER,
@@ -65,14 +77,25 @@ typedef enum {
     OP_POPN,
 
     OP_ARRAY,
+    OP_ARRAY_LITERAL,     // 2 bytes OP [element count](1 byte)
+    OP_MAP_LITERAL,       // 2 bytes OP [entry count](1 byte), the keys and values alternate on the stack
 
     OP_INHERIT,
-    OP_INVOKE,
-    OP_INVOKE_LONG,
+    OP_INVOKE,            // 4 bytes OP [name](1 byte ) [arg count] [slot hint]
+    OP_INVOKE_LONG,       // 5 bytes OP [name](2 bytes) [arg count] [slot hint]
+    OP_TAIL_INVOKE,       // OP_INVOKE whose result is returned right away, like OP_TAIL_CALL
+    OP_TAIL_INVOKE_LONG,
     OP_CLASS,
     OP_CLASS_LONG,
     OP_METHOD,
     OP_METHOD_LONG,
+
+    OP_IMPORT,            // runs the module's top level unless it is cached, leaves the module and nil on the stack
+    OP_IMPORT_LONG,
+    OP_IMPORT_BIND,       // copies the module's globals into the importing module
+
+    OP_YIELD,             // suspends the running fiber, its caller gets the value on top of the stack
+    OP_RESUME,            // runs the fiber below the value on top of the stack until it yields or returns
 } op_code_t;
 
 typedef struct {
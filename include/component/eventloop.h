@@ -0,0 +1,110 @@
+#ifndef CLOX_EVENT_LOOP_H_
+#define CLOX_EVENT_LOOP_H_
+
+#include "common.h"
+
+#include "value/value.h"
+#include "value/object/fiber.h"
+
+/**
+ * A single threaded event loop running tasks, fibers that wait for I/O and timers instead of blocking.
+ *
+ * A task doing I/O first tries the operation on a non blocking descriptor. If it would block, the
+ * operation is parked on the descriptor and the task is suspended. The loop waits on epoll for any
+ * parked descriptor or the earliest timer, completes the operation and resumes the task with its result.
+ *
+ * Every VM has its own loop, it runs once the script's top level has finished.
+ */
+
+typedef enum {
+    IO_READ,        // resumes with the string read, "" at the end of the file
+    IO_WRITE,       // resumes with the number of bytes written once all of them are
+    IO_ACCEPT,      // resumes with the accepted descriptor
+    IO_CONNECT,     // resumes with the connected descriptor
+} io_kind_t;
+
+typedef struct {
+    io_kind_t kind;
+    // IO_READ reads at most 'length' bytes, IO_WRITE writes 'data' and counts progress in 'done'
+    int length;
+    int done;
+    char* data;
+} io_operation_t;
+
+typedef struct {
+    object_fiber_t* task;
+    io_operation_t operation;
+} io_waiter_t;
+
+typedef struct {
+    object_fiber_t* task;
+    value_t value;
+} ready_task_t;
+
+typedef struct {
+    io_waiter_t reader;
+    io_waiter_t writer;
+    // events registered with epoll, 0 while the descriptor is not registered
+    uint32_t events;
+} io_watch_t;
+
+typedef struct {
+    int64_t deadline;
+    // timers with the same deadline fire in the order they were set
+    uint64_t sequence;
+    object_fiber_t* task;
+} loop_timer_t;
+
+typedef struct {
+    // -1 until a task first waits on a descriptor
+    int epoll_fd;
+
+    // ring buffer of tasks to resume
+    ready_task_t* ready;
+    int ready_head;
+    int ready_count;
+    int ready_capacity;
+
+    // min-heap on deadline
+    loop_timer_t* timers;
+    int timer_count;
+    int timer_capacity;
+    uint64_t timer_sequence;
+
+    // indexed by descriptor, a reader and a writer may wait on each one
+    io_watch_t* watches;
+    int watch_capacity;
+    // tasks parked on descriptors
+    int waiting;
+} event_loop_t;
+
+void init_event_loop(event_loop_t* loop);
+void free_event_loop(event_loop_t* loop);
+void mark_event_loop(event_loop_t* loop);
+
+// queues 'task' to be resumed with 'value'
+void loop_ready(event_loop_t* loop, object_fiber_t* task, value_t value);
+// suspends 'task' for 'milliseconds', it is resumed with nil
+void loop_sleep(event_loop_t* loop, object_fiber_t* task, double milliseconds);
+/*
+ * Parks 'operation' on 'fd' and suspends 'task' until the operation completes.
+ * Returns false if another task already waits on 'fd' in the same direction.
+ */
+bool loop_wait(event_loop_t* loop, object_fiber_t* task, int fd, io_operation_t operation);
+// wakes the tasks waiting on 'fd' with nil, the descriptor is about to be closed
+void loop_forget(event_loop_t* loop, int fd);
+
+/*
+ * Takes the next task to resume, waiting for descriptors and timers if none is ready.
+ * Returns false once no task is left waiting for anything.
+ */
+bool loop_next(event_loop_t* loop, object_fiber_t** task, value_t* value);
+
+/*
+ * Tries 'operation' once on 'fd'. Returns false if it would block,
+ * otherwise sets 'result' to the operation's result, nil on failure.
+ */
+bool io_attempt(int fd, io_operation_t* operation, value_t* result);
+void free_io_operation(io_operation_t* operation);
+
+#endif
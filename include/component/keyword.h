@@ -0,0 +1,24 @@
+#ifndef CLOX_KEYWORD_H_
+#define CLOX_KEYWORD_H_
+
+#include "common.h"
+#include "vm/scanner.h"
+
+/*
+ * Keywords are found through a perfect hash on (length, first char, last char):
+ * every keyword owns a distinct slot of a constant 64 entry table,
+ * so a lookup is one table load and at most one memcmp.
+ */
+#define KEYWORD_SLOTS      64
+#define KEYWORD_MIN_LENGTH 2
+#define KEYWORD_MAX_LENGTH 8
+
+#define KEYWORD_SLOT(length, first, last) \
+    (((length) + (uint8_t)(first) * 7 + (uint8_t)(last) * 9) & (KEYWORD_SLOTS - 1))
+
+/*
+ * returns the keyword's token type, or TOKEN_IDENTIFIER if 'start' is not a keyword
+ */
+tokentype_t keyword_type(const char* start, int length);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef CLOX_MESSAGE_H_
+#define CLOX_MESSAGE_H_
+
+#include "common.h"
+
+#include "value/value.h"
+#include "value/object/array.h"
+#include "value/object/function.h"
+
+/**
+ * A value copied out of one VM's heap so it can be rebuilt in another one.
+ * Messages live in malloc'd memory owned by nobody's garbage collector,
+ * they are created by the sending thread and consumed by the receiving thread.
+ */
+
+typedef struct channel channel_t;
+
+typedef enum {
+    MESSAGE_VALUE,      // nil, booleans and numbers, kept in 'value'
+    MESSAGE_STRING,
+    MESSAGE_LIST,
+    MESSAGE_ARRAY,
+    MESSAGE_CHANNEL,
+    MESSAGE_FUNCTION,   // a function constant inside another function
+    MESSAGE_CLOSURE,    // a function without captured variables, rebuilt as a closure
+} message_kind_t;
+
+typedef struct message message_t;
+typedef struct message_function message_function_t;
+
+struct message {
+    message_kind_t kind;
+    // the value itself for MESSAGE_VALUE, the initial value of a list
+    value_t value;
+    // characters of a string, elements of a list or an array
+    int count;
+    union {
+        char* chars;
+        message_t* items;
+        struct {
+            array_type_t type;
+            void* data;
+        } array;
+        channel_t* channel;
+        message_function_t* function;
+    } as;
+};
+
+struct message_function {
+    int arity;
+    int max_slots;
+    int upvalue_count;
+    upvalue_t upvalues[UINT8_COUNT];
+    message_t name;     // MESSAGE_VALUE holding nil for the top level function
+    int code_count;
+    uint8_t* code;
+    int* lines;
+    int constant_count;
+    message_t* constants;
+};
+
+/*
+ * Copies 'value' out of the current VM's heap.
+ * Returns false and leaves nothing to free if 'value' holds an instance, a class, a native,
+ * a closure capturing variables or nests deeper than MESSAGE_DEPTH_MAX.
+ */
+bool pack_message(value_t value, message_t* message);
+
+/*
+ * Rebuilds the message in the current VM's heap. Functions resolve their globals in vm->main.
+ */
+value_t unpack_message(message_t* message);
+
+void free_message(message_t* message);
+
+#endif
@@ -5,11 +5,15 @@
 
 typedef struct {
     bool mutable;
+    // bound by an import, a module only passes on the globals it defines itself
+    bool imported;
     value_t v;
 } var_t;
 
 bool table_set_var   (table_t* table, object_string_t* key, var_t var);
 bool table_get_var   (table_t* table, object_string_t* key, var_t* var);
+// the variable stored under 'key' to read or assign in place, NULL if there is none
+var_t* table_find_var(table_t* table, object_string_t* key);
 
 __attribute__((unused)) bool table_delete_var(table_t* table, object_string_t* key);
 
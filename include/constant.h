@@ -9,5 +9,52 @@
 #define UINT8_COUNT (UINT8_MAX + 1)
 #define OBJECT_MAX  256
 #define LIST_CAPACITY_MAX 10000000
+/*
+ * lists whose storage reaches this many bytes are backed by anonymous pages
+ * that are only materialized when written
+ */
+#define LIST_LAZY_THRESHOLD (1 << 16)
+#define ARRAY_LENGTH_MAX  (1 << 30)
+/*
+ * concatenations of two strings shorter than this are copied eagerly instead of building a rope
+ */
+#define ROPE_MIN_LENGTH   64
+// '+' refuses to build strings longer than this, doubling a rope reaches it in 30 steps
+#define STRING_LENGTH_MAX (1 << 30)
+
+// strings holding data, like flattened ropes and messages, are only interned up to this length
+#define STRING_INTERN_MAX 256
+
+/*
+ * parallel kernels run serially below PARALLEL_MIN_ELEMENTS elements,
+ * and never hand out chunks smaller than PARALLEL_CHUNK_MIN elements
+ */
+#define PARALLEL_MIN_ELEMENTS (1 << 16)
+#define PARALLEL_CHUNK_MIN    (1 << 14)
+#define PARALLEL_CHUNKS_MAX   256
+
+/*
+ * messages sent between isolates may nest lists and functions this deep,
+ * which also stops a list containing itself from being copied forever
+ */
+#define MESSAGE_DEPTH_MAX 64
+
+// stack traces longer than twice this many frames only show this many at either end
+#define STACK_TRACE_FRAMES 16
+
+// read() returns at most this many bytes at a time
+#define IO_READ_MAX (1 << 20)
+
+// lines() readers start with a buffer of this many bytes, it only grows for lines longer than that
+#define READER_BUFFER_SIZE (1 << 16)
+
+// bytes print collects before writing them to stdout
+#define OUTPUT_BUFFER_SIZE (1 << 13)
+
+// bench() keeps one timing per call
+#define BENCH_ITERATIONS_MAX (1 << 24)
+
+// instances of a class reserve room for at most this many fields up front, bigger ones grow as usual
+#define FIELDS_RESERVE_MAX 64
 
 #endif
\ No newline at end of file
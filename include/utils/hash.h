@@ -0,0 +1,13 @@
+#ifndef CLOX_HASH_H
+#define CLOX_HASH_H
+
+#include "common.h"
+
+/*
+ * Hash of a byte string, consumed 8 bytes at a time.
+ * Every interned string, identifier token and string literal token is hashed with this function,
+ * so a hash computed by the scanner can be reused when the compiler interns the token.
+ */
+uint32_t hash_bytes(const char* key, int length);
+
+#endif //CLOX_HASH_H
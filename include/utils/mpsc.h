@@ -0,0 +1,33 @@
+#ifndef CLOX_MPSC_H_
+#define CLOX_MPSC_H_
+
+#include <stdatomic.h>
+
+#include "common.h"
+
+/**
+ * An intrusive lock-free multi producer, single consumer queue.
+ *
+ * Any thread may push, only one thread at a time may pop. A push is a single atomic exchange,
+ * a pop never blocks. The queue owns a stub node so it is never empty internally.
+ */
+
+typedef struct mpsc_node {
+    _Atomic(struct mpsc_node*) next;
+} mpsc_node_t;
+
+typedef struct {
+    _Atomic(mpsc_node_t*) tail;
+    mpsc_node_t* head;
+    mpsc_node_t  stub;
+} mpsc_queue_t;
+
+void mpsc_init(mpsc_queue_t* queue);
+void mpsc_push(mpsc_queue_t* queue, mpsc_node_t* node);
+/*
+ *  Returns the oldest node, or NULL if the queue is empty
+ *  or the next node is still being linked in by a producer.
+ */
+mpsc_node_t* mpsc_pop(mpsc_queue_t* queue);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef CLOX_OUTPUT_H
+#define CLOX_OUTPUT_H
+
+#include <stdio.h>
+
+#include "common.h"
+
+/*
+ * A write buffer in front of a FILE that formats numbers itself instead of going through printf.
+ * It hands its bytes to the FILE when full, and after every newline when line buffered, which
+ * the VM picks for terminals so interactive output shows up line by line.
+ * Every function returns the number of characters written.
+ */
+typedef struct {
+    FILE* file;
+    char* buffer;
+    int capacity;
+    int count;
+    bool line_buffered;
+} output_t;
+
+void init_output(output_t* out, FILE* file, char* buffer, int capacity, bool line_buffered);
+// hands the buffered bytes to the FILE, which may still buffer them, fflush() it to be sure they are written
+void flush_output(output_t* out);
+
+int output_write (output_t* out, const char* chars, int length);
+int output_string(output_t* out, const char* string);
+int output_int   (output_t* out, int64_t value);
+// the shortest decimal that reads back as 'value', laid out the way %g lays out numbers
+int output_float (output_t* out, double value);
+int output_format(output_t* out, const char* format, ...);
+
+#endif //CLOX_OUTPUT_H
@@ -0,0 +1,67 @@
+#ifndef CLOX_SIMD_H_
+#define CLOX_SIMD_H_
+
+#include "common.h"
+
+/**
+ * Bulk kernels over packed numeric buffers.
+ *
+ * With GCC/Clang the kernels are written with generic vector extensions, which lower to
+ * SSE2 on a baseline x86-64 build and to AVX2 when compiled with -mavx2.
+ * Other compilers get the scalar loops.
+ */
+
+typedef enum {
+    SIMD_ADD,
+    SIMD_SUB,
+    SIMD_MUL,
+    SIMD_DIV,
+} simd_op_t;
+
+int64_t  simd_sum_i64(const int64_t* a, size_t n);
+double   simd_sum_f64(const double*  a, size_t n);
+uint64_t simd_sum_u8 (const uint8_t* a, size_t n);
+
+void simd_fill_i64(int64_t* a, size_t n, int64_t v);
+void simd_fill_f64(double*  a, size_t n, double  v);
+
+/*  n must be at least 1  */
+void simd_min_max_i64(const int64_t* a, size_t n, int64_t* min, int64_t* max);
+void simd_min_max_f64(const double*  a, size_t n, double*  min, double*  max);
+void simd_min_max_u8 (const uint8_t* a, size_t n, uint8_t* min, uint8_t* max);
+
+int64_t simd_dot_i64(const int64_t* a, const int64_t* b, size_t n);
+double  simd_dot_f64(const double*  a, const double*  b, size_t n);
+int64_t simd_dot_u8 (const uint8_t* a, const uint8_t* b, size_t n);
+
+/*
+ *  dst[i] = a[i] op b[i]
+ *  integer division must be checked for zero divisors by the caller
+ */
+void simd_binary_i64(simd_op_t op, int64_t* dst, const int64_t* a, const int64_t* b, size_t n);
+void simd_binary_f64(simd_op_t op, double*  dst, const double*  a, const double*  b, size_t n);
+void simd_binary_u8 (simd_op_t op, uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n);
+
+/*  dst[i] = a[i] op scalar  */
+void simd_scalar_i64(simd_op_t op, int64_t* dst, const int64_t* a, int64_t s, size_t n);
+void simd_scalar_f64(simd_op_t op, double*  dst, const double*  a, double  s, size_t n);
+void simd_scalar_u8 (simd_op_t op, uint8_t* dst, const uint8_t* a, uint8_t s, size_t n);
+
+uint64_t simd_popcount(const uint64_t* words, size_t n);
+
+/*
+ * Text scanning over NUL terminated buffers, each returns the first byte that ends the run.
+ * 'newlines' (may be NULL) is incremented by the number of '\n' bytes skipped.
+ */
+// ' ', '\t', '\r', '\n'
+const char* simd_skip_whitespace(const char* p, int* newlines);
+// [A-Za-z0-9_]
+const char* simd_skip_identifier(const char* p);
+// [0-9]
+const char* simd_skip_digits    (const char* p);
+// stops at '\n' or the terminator
+const char* simd_find_line_end  (const char* p);
+// stops at '"' or the terminator
+const char* simd_find_quote     (const char* p, int* newlines);
+
+#endif
@@ -22,6 +22,8 @@ typedef struct {
 
 void init_table   (table_t* table);
 void free_table   (table_t* table);
+// grows 'table' so that it holds 'count' entries without rehashing
+void table_reserve(table_t* table, int count);
 
 bool table_set    (table_t* table, object_string_t* key, void* value);
 bool table_get    (table_t* table, object_string_t* key, void** value);
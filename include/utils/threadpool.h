@@ -0,0 +1,28 @@
+#ifndef CLOX_THREADPOOL_H_
+#define CLOX_THREADPOOL_H_
+
+#include "common.h"
+
+/**
+ * A process wide pool of worker threads for data parallel kernels.
+ *
+ * Workers are started on first use, one per online cpu minus the calling thread,
+ * or CLOX_THREADS - 1 if the environment variable is set.
+ * Tasks run on worker threads and MUST NOT touch the Lox heap: no allocation,
+ * no interning, no value_t holding objects created there.
+ */
+
+typedef void (*parallel_task_t)(void* context, int chunk);
+
+/*  number of threads taking part in a parallel_for, including the caller  */
+int  parallel_threads();
+
+/*
+ *  Runs task(context, i) for every i in [0, chunks), the calling thread takes part.
+ *  Returns once all chunks are finished. A single chunk runs inline on the caller.
+ */
+void parallel_for(int chunks, parallel_task_t task, void* context);
+
+void shutdown_thread_pool();
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CLOX_NATIVE_ARRAY_H
+#define CLOX_NATIVE_ARRAY_H
+
+#include "value/value.h"
+
+value_t int_array_native  (int arg_count, value_t* args);
+value_t float_array_native(int arg_count, value_t* args);
+value_t byte_array_native (int arg_count, value_t* args);
+value_t bit_array_native  (int arg_count, value_t* args);
+
+value_t array_fill_native (int arg_count, value_t* args);
+value_t array_sum_native  (int arg_count, value_t* args);
+value_t array_min_native  (int arg_count, value_t* args);
+value_t array_max_native  (int arg_count, value_t* args);
+value_t array_dot_native  (int arg_count, value_t* args);
+
+/*  array_op(dst, a, b), b is either an array like a or a number  */
+value_t array_add_native  (int arg_count, value_t* args);
+value_t array_sub_native  (int arg_count, value_t* args);
+value_t array_mul_native  (int arg_count, value_t* args);
+value_t array_div_native  (int arg_count, value_t* args);
+
+value_t bit_count_native  (int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_ARRAY_H
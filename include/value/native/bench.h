@@ -0,0 +1,13 @@
+#ifndef CLOX_NATIVE_BENCH_H
+#define CLOX_NATIVE_BENCH_H
+
+#include "value/value.h"
+
+/*
+ * bench(fn, iterations) calls fn without arguments 'iterations' times after a warmup and returns an instance
+ * with the fields 'iterations', 'min', 'median' and 'p99' in nanoseconds, and 'allocations',
+ * the objects allocated per call on average.
+ */
+value_t bench_native(int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_BENCH_H
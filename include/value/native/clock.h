@@ -7,6 +7,14 @@
 
 #include "value/value.h"
 
+// nanoseconds on a clock that never jumps, only differences between readings mean anything
+int64_t monotonic_ns();
+
+// processor time of the whole process in seconds, a float
 value_t clock_native(int arg_count, value_t* args);
+// monotonic nanoseconds, for measuring how long something took
+value_t clock_ns_native(int arg_count, value_t* args);
+// nanoseconds since the Unix epoch
+value_t time_ns_native(int arg_count, value_t* args);
 
 #endif //CLOX_CLOCK_H
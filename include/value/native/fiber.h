@@ -0,0 +1,11 @@
+#ifndef CLOX_NATIVE_FIBER_H
+#define CLOX_NATIVE_FIBER_H
+
+#include "value/value.h"
+
+// fiber(function) -> a fiber that runs 'function' on its first resume, the function takes at most one argument
+value_t fiber_native     (int arg_count, value_t* args);
+// fiber_done(fiber) -> true once the fiber's function has returned
+value_t fiber_done_native(int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_FIBER_H
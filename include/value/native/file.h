@@ -0,0 +1,17 @@
+#ifndef CLOX_NATIVE_FILE_H
+#define CLOX_NATIVE_FILE_H
+
+#include "value/value.h"
+
+/*
+ * Reading files by path. Files that cannot be opened give nil.
+ */
+
+// read_file(path) -> the whole file as a string, mapped into memory instead of copied
+value_t read_file_native(int arg_count, value_t* args);
+// lines(path) -> a reader returning the lines of the file one by one
+value_t lines_native    (int arg_count, value_t* args);
+// read_line(reader) -> the next line without its newline, nil after the last one
+value_t read_line_native(int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_FILE_H
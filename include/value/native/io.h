@@ -0,0 +1,35 @@
+#ifndef CLOX_NATIVE_IO_H
+#define CLOX_NATIVE_IO_H
+
+#include "value/value.h"
+
+/*
+ * Tasks are fibers run by the event loop once the top level code has returned.
+ * Inside a task, I/O that would block and sleep() suspend the task and let the others run,
+ * anywhere else they block the whole VM. Failing operations return nil.
+ */
+
+// task(function, argument) -> a task calling 'function' with 'argument', the function takes at most one argument
+value_t task_native   (int arg_count, value_t* args);
+// sleep(milliseconds)
+value_t sleep_native  (int arg_count, value_t* args);
+// read(fd, max) -> a string of at most 'max' bytes, "" at the end of the file
+value_t read_native   (int arg_count, value_t* args);
+// write(fd, string) -> the number of bytes written, all of them unless it fails
+value_t write_native  (int arg_count, value_t* args);
+// flush() hands what print collected to stdout right away
+value_t flush_native  (int arg_count, value_t* args);
+// open(path, mode) -> a descriptor, mode is "r", "w" or "a"
+value_t open_native   (int arg_count, value_t* args);
+// close(fd) -> true if it was closed, tasks waiting on it are resumed with nil
+value_t close_native  (int arg_count, value_t* args);
+// pipe() -> [read end, write end]
+value_t pipe_native   (int arg_count, value_t* args);
+// listen(port) -> a descriptor accepting TCP connections on every interface
+value_t listen_native (int arg_count, value_t* args);
+// accept(fd) -> the descriptor of the next connection
+value_t accept_native (int arg_count, value_t* args);
+// connect(host, port) -> a descriptor connected over TCP, resolving 'host' blocks
+value_t connect_native(int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_IO_H
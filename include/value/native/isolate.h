@@ -0,0 +1,26 @@
+#ifndef CLOX_NATIVE_ISOLATE_H
+#define CLOX_NATIVE_ISOLATE_H
+
+#include "value/value.h"
+
+/*
+ * Isolates are functions running in a VM of their own on a separate thread.
+ * They share nothing but channels: every value sent is copied into the receiver's heap.
+ */
+
+// channel() -> a new channel
+value_t channel_native(int arg_count, value_t* args);
+// send(channel, value), value may hold nil, booleans, numbers, strings, lists, arrays, channels and functions
+value_t send_native   (int arg_count, value_t* args);
+// receive(channel) -> the oldest message, waits for one if there is none
+value_t receive_native(int arg_count, value_t* args);
+/*
+ * spawn(function, argument) -> a channel receiving the function's result once it returns.
+ * The isolate starts with a copy of every global of the calling module that can be sent.
+ */
+value_t spawn_native  (int arg_count, value_t* args);
+
+// waits for every isolate still running
+void shutdown_isolates();
+
+#endif //CLOX_NATIVE_ISOLATE_H
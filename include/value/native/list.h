@@ -0,0 +1,11 @@
+#ifndef CLOX_NATIVE_LIST_H
+#define CLOX_NATIVE_LIST_H
+
+#include "value/value.h"
+
+value_t len_native   (int arg_count, value_t* args);
+value_t append_native(int arg_count, value_t* args);
+value_t insert_native(int arg_count, value_t* args);
+value_t pop_native   (int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_LIST_H
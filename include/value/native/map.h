@@ -0,0 +1,17 @@
+#ifndef CLOX_NATIVE_MAP_H
+#define CLOX_NATIVE_MAP_H
+
+#include "value/value.h"
+
+/*
+ * Maps are read and written with m[key], a missing key reads as nil, len(m) is the number of entries.
+ */
+
+// keys(map) -> a list of the map's keys, in no particular order
+value_t keys_native  (int arg_count, value_t* args);
+// has(map, key) -> true if the map holds 'key', even when its value is nil
+value_t has_native   (int arg_count, value_t* args);
+// remove(map, key) -> true if 'key' was in the map
+value_t remove_native(int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_MAP_H
@@ -0,0 +1,17 @@
+#ifndef CLOX_NATIVE_MATH_H
+#define CLOX_NATIVE_MATH_H
+
+#include "value/value.h"
+
+/*
+ * Integers stay integers where the result is exact: abs, min and max of ints, pow of an int to a
+ * non-negative int. floor always returns an int, sqrt always a float.
+ */
+value_t sqrt_native (int arg_count, value_t* args);
+value_t floor_native(int arg_count, value_t* args);
+value_t abs_native  (int arg_count, value_t* args);
+value_t min_native  (int arg_count, value_t* args);
+value_t max_native  (int arg_count, value_t* args);
+value_t pow_native  (int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_MATH_H
@@ -0,0 +1,21 @@
+#ifndef CLOX_NATIVE_PARALLEL_H
+#define CLOX_NATIVE_PARALLEL_H
+
+#include "value/value.h"
+
+/*
+ * Data parallel kernels over int and float arrays, executed on the worker thread pool.
+ * Small inputs run serially on the calling thread.
+ */
+
+value_t par_sum_native       (int arg_count, value_t* args);
+// par_map(dst, src, op, scalar), op is one of "+", "-", "*", "/"
+value_t par_map_native       (int arg_count, value_t* args);
+// par_count(src, cmp, scalar), cmp is one of "<", "<=", ">", ">=", "==", "!="
+value_t par_count_native     (int arg_count, value_t* args);
+// par_prefix_sum(dst, src), inclusive scan
+value_t par_prefix_sum_native(int arg_count, value_t* args);
+// par_histogram(src, bins, lo, hi) -> int array, values outside [lo, hi) are skipped
+value_t par_histogram_native (int arg_count, value_t* args);
+
+#endif //CLOX_NATIVE_PARALLEL_H
@@ -23,8 +23,6 @@ typedef struct clox_object {
 
 #define OBJ_TYPE(value)    (AS_OBJECT(value)->type)
 
-extern list_t temporary_objs;
-
 static inline bool is_object_type(value_t value, object_type_t type) {
     return IS_OBJECT(value) && (AS_OBJECT(value))->type == type;
 }
@@ -34,7 +32,7 @@ object_t* allocate_object(size_t size, object_type_t type);
     (type*)allocate_object(sizeof(type), object_type)
 
 
-int print_object(value_t value);
+int write_object(output_t* out, value_t value);
 void blacken_object(object_t* obj);
 void merge_temporary();
 
@@ -0,0 +1,46 @@
+#ifndef CLOX_ARRAY_H
+#define CLOX_ARRAY_H
+
+#include "value/value.h"
+
+/*
+ * Typed arrays store their elements unboxed and densely packed,
+ * unlike lists which keep a tagged value_t per element.
+ */
+typedef enum {
+    ARRAY_INT,      // int64_t
+    ARRAY_FLOAT,    // double
+    ARRAY_BYTE,     // uint8_t
+    ARRAY_BIT,      // one bit per bool, packed into uint64_t words
+} array_type_t;
+
+typedef struct clox_array object_array_t;
+
+struct clox_array {
+    struct clox_object obj;
+
+    array_type_t type;
+    int count;
+    void* data;
+};
+
+#define IS_ARRAY(value) is_object_type(value, OBJ_ARRAY)
+
+#define AS_ARRAY(value) ((object_array_t*)AS_OBJECT(value))
+
+#define ARRAY_BIT_WORDS(count) (((size_t)(count) + 63) >> 6)
+
+object_array_t* new_array(array_type_t type, uint32_t count);
+
+size_t      array_data_size (array_type_t type, uint32_t count);
+const char* array_type_name (array_type_t type);
+
+/*
+ *  return  0 on success
+ *         -1 if the index is out of bound
+ *         -2 if the value cannot be stored in the array
+ */
+int  get_array_value(object_array_t* array, uint32_t index, value_t *value);
+int  set_array_value(object_array_t* array, uint32_t index, value_t value);
+
+#endif //CLOX_ARRAY_H
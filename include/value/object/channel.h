@@ -0,0 +1,39 @@
+#ifndef CLOX_OBJECT_CHANNEL_H_
+#define CLOX_OBJECT_CHANNEL_H_
+
+#include "value/object.h"
+#include "component/message.h"
+
+/*
+ * A channel is shared by every VM holding it, it lives outside of all heaps and is reference counted.
+ * Each VM refers to it through its own OBJ_CHANNEL object.
+ *
+ * Any number of threads may send, one thread at a time may receive:
+ * messages go through a lock-free mpsc queue, a receiver finding it empty parks until a sender wakes it.
+ */
+channel_t* new_shared_channel();
+void retain_channel (channel_t* channel);
+void release_channel(channel_t* channel);
+
+// takes ownership of 'message'
+void channel_send(channel_t* channel, message_t message);
+/*
+ * Blocks until a message arrives. Returns false without waiting
+ * if another thread is already receiving from the channel.
+ */
+bool channel_receive(channel_t* channel, message_t* message);
+
+typedef struct clox_channel object_channel_t;
+
+struct clox_channel {
+    struct clox_object obj;
+    channel_t* channel;
+};
+
+#define IS_CHANNEL(value)  is_object_type(value, OBJ_CHANNEL)
+#define AS_CHANNEL(value)  ((object_channel_t*)AS_OBJECT(value))
+
+// takes a reference to 'channel', released when the object is freed
+object_channel_t* new_channel(channel_t* channel);
+
+#endif
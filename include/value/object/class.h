@@ -10,18 +10,42 @@
 #include "utils/table.h"
 #include "function.h"
 
+typedef struct {
+    object_string_t* name;
+    object_closure_t* method;
+} method_slot_t;
+
 typedef struct clox_klass object_class_t;
 
+/*
+ * Methods live in 'vtable', 'methods' maps a method name to its slot there.
+ * A subclass starts with copies of both, so an inherited method keeps its slot down the hierarchy
+ * and an override only replaces the closure in that slot.
+ */
 struct clox_klass {
     struct clox_object obj;
 
     object_string_t* name;
 
-    // This is a value table
+    // This is a value table, its values are slots
     table_t methods;
+    method_slot_t* vtable;
+    int method_count;
+    int method_capacity;
+
+    // the 'init' method, NULL if the class has none
+    object_closure_t* initializer;
+    // the most fields an instance has been seen with, new instances reserve room for that many
+    int field_count;
 };
 
 object_class_t* new_class(object_string_t* name);
+// adds the method to 'klass', overriding the one in the slot of the same name if there is one
+void class_define_method(object_class_t* klass, object_string_t* name, object_closure_t* method);
+// copies the slots of 'superclass' into 'klass', which has no methods yet
+void class_inherit(object_class_t* klass, object_class_t* superclass);
+// the slot of the method 'name', -1 if the class has none
+int class_find_method(object_class_t* klass, object_string_t* name);
 
 #define AS_CLASS(value)    ((object_class_t*)AS_OBJECT(value))
 #define IS_CLASS(value)    is_object_type(value, OBJ_CLASS)
@@ -38,6 +62,8 @@ struct clox_instance {
 };
 
 object_instance_t* new_instance(object_class_t* klass);
+// sets the field 'name', marking the name as one that may shadow methods
+void instance_set_field(object_instance_t* instance, object_string_t* name, value_t value);
 
 #define AS_INSTANCE(value) ((object_instance_t*)AS_OBJECT(value))
 #define IS_INSTANCE(value) is_object_type(value, OBJ_INSTANCE)
@@ -0,0 +1,93 @@
+#ifndef CLOX_OBJECT_FIBER_H_
+#define CLOX_OBJECT_FIBER_H_
+
+#include "constant.h"
+
+#include "utils/linklist.h"
+
+#include "value/object.h"
+#include "value/object/function.h"
+
+// default depth limit of every call stack, the CLOX_FRAMES_MAX environment variable overrides it
+#define FRAMES_MAX (1 << 16)
+/*
+ * Call stacks start with room for FRAMES_INITIAL frames and STACK_INITIAL values and double as needed.
+ * Before every call there is room for the callee's 'max_slots' values and FRAME_SLOTS more,
+ * which natives called by the callee may push.
+ */
+#define FRAMES_INITIAL 8
+#define FRAME_SLOTS    (2 * UINT8_COUNT)
+#define STACK_INITIAL  (2 * FRAME_SLOTS)
+
+typedef struct {
+    object_closure_t *closure;
+    uint8_t* ip;
+    value_t* slots;
+} callframe_t;
+
+/*
+ * The values and call frames of one thread of execution.
+ * The VM has a root call stack and every fiber owns one. The VM copies the running one
+ * into its own fields, so switching between them only swaps a few pointers.
+ */
+typedef struct {
+    callframe_t*    frames;
+    int             frame_count;
+    int             frame_capacity;
+
+    value_t*        stack;
+    value_t*        stack_top;
+    int             stack_capacity;
+
+    // run() returns once 'frame_count' drops back to this, a native calling into Lox raises it for the call
+    int             frame_base;
+
+    // upvalues still pointing into 'stack'
+    list_t open_upvalues;
+} call_stack_t;
+
+void init_call_stack(call_stack_t* stack);
+void free_call_stack(call_stack_t* stack);
+/*
+ * Makes room for one more frame and 'slots' values above 'stack_top'. Growing moves the stack,
+ * the frames and the open upvalues are pointed at the new one, raw pointers into it are stale afterwards.
+ */
+void grow_call_stack(call_stack_t* stack, int slots);
+void mark_call_stack(call_stack_t* stack);
+
+typedef enum {
+    // created, its function has not started yet
+    FIBER_NEW,
+    // stopped at a yield
+    FIBER_SUSPENDED,
+    // running, or waiting for a fiber it resumed
+    FIBER_RUNNING,
+    // a task parked by a native until the event loop resumes it
+    FIBER_WAITING,
+    // its function returned, or a runtime error unwound it
+    FIBER_DONE,
+} fiber_state_t;
+
+typedef struct clox_fiber object_fiber_t;
+
+/*
+ * A function running on a call stack of its own. 'resume' runs it until it yields or returns,
+ * 'yield' hands a value back to the fiber that resumed it.
+ */
+struct clox_fiber {
+    struct clox_object obj;
+    object_closure_t* closure;
+    fiber_state_t state;
+    // tasks are fibers scheduled by the event loop instead of resumed by hand
+    bool task;
+    // the fiber that resumed this one, NULL if it was resumed from the root call stack
+    object_fiber_t* caller;
+    call_stack_t stack;
+};
+
+#define IS_FIBER(value)  is_object_type(value, OBJ_FIBER)
+#define AS_FIBER(value)  ((object_fiber_t*)AS_OBJECT(value))
+
+object_fiber_t* new_fiber(object_closure_t* closure);
+
+#endif
@@ -28,12 +28,15 @@ struct clox_upvalue {
 
     value_t closed;
     value_t* location;
-    bool mutable;
+    // the fiber whose stack 'location' points into while open, it has to outlive the upvalue
+    struct clox_fiber* fiber;
 };
 
 typedef struct {
     uint8_t index;
     bool is_local;
+    // whether the captured variable is mutable, only the compiler needs it
+    bool mutable;
 } upvalue_t;
 
 object_upvalue_t* new_upvalue(value_t* slot);
@@ -43,12 +46,16 @@ typedef struct clox_function object_function_t;
 struct clox_function {
     struct clox_object obj;
     int              arity;
+    // the most values a frame running the function holds, counting the callee slot and the arguments
+    int              max_slots;
 
     upvalue_t        upvalues[UINT8_COUNT];
     int              upvalue_count;
 
     chunk_t          chunk;
     object_string_t* name;
+    // the module whose globals the function's code reads and writes
+    struct clox_module* module;
 };
 
 object_function_t* new_function();
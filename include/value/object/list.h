@@ -16,8 +16,21 @@ struct clox_list {
      * If unsigned, return this value when fetched
      */
     value_t initial;
+    /*
+     * count    -> number of elements visible to the script
+     * capacity -> number of slots allocated, grows geometrically on append
+     */
+    int count;
     int capacity;
     value_t* list;
+
+    /*
+     * Large lists are mmap'd, untouched pages read as zero, i.e. VAL_NONE -> initial.
+     * One bit per page records whether the page has ever been written,
+     * NULL if the storage is an ordinary heap array.
+     */
+    uint8_t* touched;
+    size_t   mapped_size;
 };
 
 #define IS_LIST(value) is_object_type(value, OBJ_LIST)
@@ -29,4 +42,11 @@ object_list_t* new_list(uint32_t capacity, value_t value);
 int  get_list_value(object_list_t* list, uint32_t index, value_t *value);
 int  set_list_value(object_list_t* list, uint32_t index, value_t value);
 
+int  append_list_value(object_list_t* list, value_t value);
+int  insert_list_value(object_list_t* list, uint32_t index, value_t value);
+int  pop_list_value   (object_list_t* list, value_t *value);
+
+void mark_list_values (object_list_t* list);
+void free_list_storage(object_list_t* list);
+
 #endif //CLOX_LIST_H
@@ -0,0 +1,58 @@
+#ifndef CLOX_OBJECT_MAP_H_
+#define CLOX_OBJECT_MAP_H_
+
+#include "value/object.h"
+
+/*
+ * A hash map keyed by numbers, strings and booleans, laid out as a Swiss table.
+ * The slots are split into groups of MAP_GROUP_WIDTH, every slot has a control byte that holds 7 bits
+ * of its key's hash or marks it empty or deleted. A lookup compares a whole group of control bytes
+ * with the hash at once and only compares the keys of the slots that match.
+ */
+#define MAP_GROUP_WIDTH 16
+
+typedef struct {
+    value_t key;
+    value_t value;
+} map_entry_t;
+
+typedef struct clox_map object_map_t;
+
+struct clox_map {
+    struct clox_object obj;
+    int count;
+    // empty slots that can still be filled before the map has to grow
+    int growth_left;
+    // 0, or a power of two no smaller than MAP_GROUP_WIDTH
+    int capacity;
+    uint8_t* control;
+    map_entry_t* entries;
+};
+
+#define IS_MAP(value)  is_object_type(value, OBJ_MAP)
+#define AS_MAP(value)  ((object_map_t*)AS_OBJECT(value))
+
+// room for 'count' entries before the map first grows
+object_map_t* new_map(int count);
+
+/*
+ * The key 'value' is stored as: ropes are flattened and -0.0 becomes 0.0. Strings match by content,
+ * those that are not interned are hashed the first time they key a map.
+ * Returns false if 'value' cannot be a key. Float keys match exactly, not within the tolerance of '=='.
+ */
+bool map_key(value_t value, value_t* key);
+
+// 'key' must come from map_key()
+bool map_get   (object_map_t* map, value_t key, value_t* value);
+void map_set   (object_map_t* map, value_t key, value_t value);
+bool map_remove(object_map_t* map, value_t key);
+
+// slots without an entry have their control byte's top bit set
+static inline bool map_slot_full(object_map_t* map, int slot) {
+    return map->control[slot] < 0x80;
+}
+
+void mark_map_entries(object_map_t* map);
+void free_map_storage(object_map_t* map);
+
+#endif
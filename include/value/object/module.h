@@ -0,0 +1,43 @@
+#ifndef CLOX_OBJECT_MODULE_H_
+#define CLOX_OBJECT_MODULE_H_
+
+#include "value/object.h"
+#include "value/object/string.h"
+#include "utils/table.h"
+
+typedef struct clox_module object_module_t;
+
+/*
+ * A source file compiled into its own top level function.
+ * Every function compiled from the file points back to its module and resolves globals in 'globals',
+ * falling back to the natives in vm->globals.
+ */
+struct clox_module {
+    struct clox_object obj;
+    // canonical path of the source file, the key of vm->modules
+    object_string_t* path;
+    // This is a var table
+    table_t globals;
+    // set once the module's top level code has run to the end
+    bool loaded;
+    // bit i is set once a global of the module is named like intrinsic i, its intrinsic opcodes then call the global
+    uint32_t shadowed_intrinsics;
+};
+
+#define IS_MODULE(value)   is_object_type(value, OBJ_MODULE)
+#define AS_MODULE(value)   ((object_module_t*)AS_OBJECT(value))
+
+object_module_t* new_module(object_string_t* path);
+
+/*
+ * Resolves 'name' relative to the directory of the importing module's path.
+ * Returns the canonical path, or NULL when the file does not exist.
+ */
+object_string_t* resolve_module_path(object_module_t* importer, object_string_t* name);
+
+/*
+ * Reads the whole file into a NUL terminated heap buffer, NULL on failure.
+ */
+char* read_module_source(const char* path);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef CLOX_OBJECT_READER_H_
+#define CLOX_OBJECT_READER_H_
+
+#include "value/object.h"
+#include "value/object/string.h"
+
+typedef struct clox_reader object_reader_t;
+
+/*
+ * Reads a file one line at a time through a buffer of READER_BUFFER_SIZE bytes,
+ * so files of any size are scanned in constant memory. The buffer only grows to hold a longer line.
+ */
+struct clox_reader {
+    struct clox_object obj;
+    // -1 once the end of the file was reached or the reader was closed
+    int fd;
+    char* buffer;
+    int capacity;
+    // the bytes not returned yet are buffer[start, end)
+    int start;
+    int end;
+};
+
+#define IS_READER(value)  is_object_type(value, OBJ_READER)
+#define AS_READER(value)  ((object_reader_t*)AS_OBJECT(value))
+
+// takes ownership of 'fd', closed at the end of the file or when the reader is freed
+object_reader_t* new_reader(int fd);
+// the next line without its '\n', NULL after the last one
+object_string_t* reader_next_line(object_reader_t* reader);
+void close_reader(object_reader_t* reader);
+
+#endif
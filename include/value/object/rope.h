@@ -0,0 +1,43 @@
+#ifndef CLOX_OBJECT_ROPE_H_
+#define CLOX_OBJECT_ROPE_H_
+
+#include "value/object.h"
+#include "value/object/string.h"
+
+typedef struct clox_rope object_rope_t;
+
+/*
+ * A lazy concatenation 'left + right', both sides are strings or ropes.
+ * The rope is flattened into an interned string the first time its characters are needed,
+ * after which 'flat' is kept and the children are released.
+ */
+struct clox_rope {
+    struct clox_object obj;
+    int length;
+    object_t* left;
+    object_t* right;
+    object_string_t* flat;
+};
+
+#define IS_ROPE(value)   is_object_type(value, OBJ_ROPE)
+
+#define AS_ROPE(value)   ((object_rope_t*)AS_OBJECT(value))
+
+static inline bool is_string_like(value_t value) {
+    return IS_STRING(value) || IS_ROPE(value);
+}
+
+int string_like_length(value_t value);
+
+/*
+ * Short results are copied and interned right away, longer ones become rope nodes.
+ * Returns NONE_VAL when the result would be longer than STRING_LENGTH_MAX.
+ */
+value_t concatenate(value_t lhs, value_t rhs);
+object_string_t* flatten_rope(object_rope_t* rope);
+/*
+ * returns strings unchanged and flattens ropes, any other value is returned as is
+ */
+value_t flatten_value(value_t value);
+
+#endif
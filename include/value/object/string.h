@@ -1,14 +1,30 @@
 #ifndef CLOX_OBJECT_STRING_H_
 #define CLOX_OBJECT_STRING_H_
 
+#include <string.h>
+
+#include "utils/hash.h"
 #include "value/object.h"
 
 typedef struct clox_string object_string_t;
 
+/*
+ * Interned strings are unique for their chars, so they compare by pointer and can key tables.
+ * Interning hashes the chars and probes the string table though, which is wasted on data nobody looks up:
+ * strings read by I/O and long strings built at runtime are not interned, they are hashed the first time
+ * they key a map and compare by content.
+ */
 struct clox_string {
     struct clox_object obj;
     int length;
+    // valid once 'hashed' is set, interned strings are hashed when they are created
     uint32_t hash;
+    // set once an instance field is named by this string, only such names can shadow a method
+    bool field_name;
+    // 'chars' is a private read only mapping of a file, freeing the string unmaps it
+    bool mapped;
+    bool interned;
+    bool hashed;
     char* chars;
 };
 
@@ -17,8 +33,41 @@ struct clox_string {
 #define AS_STRING(value)   ((object_string_t*)AS_OBJECT(value))
 #define AS_CSTRING(value)  (((object_string_t*)AS_OBJECT(value))->chars)
 
+static inline uint32_t string_hash(object_string_t* string) {
+    if (!string->hashed) {
+        string->hash = hash_bytes(string->chars, string->length);
+        string->hashed = true;
+    }
+    return string->hash;
+}
+
+static inline bool strings_equal(object_string_t* a, object_string_t* b) {
+    if (a == b)
+        return true;
+    if ((a->interned && b->interned) || a->length != b->length)
+        return false;
+    if (a->hashed && b->hashed && a->hash != b->hash)
+        return false;
+    return memcmp(a->chars, b->chars, a->length) == 0;
+}
+
+// copy_string(), copy_string_hashed() and take_string() intern, names must be made with them
 object_string_t* copy_string(const char* chars, int length);
+/*
+ * 'hash' must equal hash_bytes(chars, length), e.g. the hash carried by a scanned token
+ */
+object_string_t* copy_string_hashed(const char* chars, int length, uint32_t hash);
 object_string_t* take_string(char* chars, int length);
+// strings holding data, interned only up to STRING_INTERN_MAX bytes
+object_string_t* copy_data_string(const char* chars, int length);
+object_string_t* take_data_string(char* chars, int length);
+// never interned, for bytes read by I/O
+object_string_t* copy_uninterned_string(const char* chars, int length);
+/*
+ * A string holding the first 'length' bytes of the open file 'fd', mapped into memory rather than copied.
+ * It is not interned. Returns NULL if the file cannot be mapped. The file must not shrink while the string is alive.
+ */
+object_string_t* map_string(int fd, int length);
 object_string_t* concatenate_string(const char* chars, int len, const char* rhs, int r_len);
 
 #endif
\ No newline at end of file
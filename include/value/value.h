@@ -4,10 +4,13 @@
 #include "common.h"
 
 #include "utils/linklist.h"
+#include "utils/output.h"
 
 typedef enum {
     OBJ_STRING,
+    OBJ_ROPE,
     OBJ_LIST,
+    OBJ_ARRAY,
     OBJ_FUNCTION,
     OBJ_NATIVE,
     OBJ_CLASS,
@@ -15,6 +18,11 @@ typedef enum {
     OBJ_CLOSURE,
     OBJ_UPVALUE,
     OBJ_BOUND_METHOD,
+    OBJ_MODULE,
+    OBJ_CHANNEL,
+    OBJ_FIBER,
+    OBJ_READER,
+    OBJ_MAP,
 } object_type_t;
 
 typedef struct clox_object {
@@ -64,6 +72,7 @@ bool IS_NUMBER(value_t value);
 */
 double AS_NUMBER(value_t value);
 
+#define NONE_VAL           ((value_t) {VAL_NONE,  {.number = 0}})
 #define BOOL_VAL(value)    ((value_t) {VAL_BOOL,  {.boolean = value}})
 #define NIL_VAL            ((value_t) {VAL_NIL,   {.number = 0}})
 #define INT_VAL(value)     ((value_t) {VAL_INT,   {.integer = value}})
@@ -82,6 +91,11 @@ void init_value_array (value_array_t* array);
 void write_value_array(value_array_t* array, value_t value);
 void free_value_array (value_array_t* array);
 
+/*
+ * write_value() formats 'value' the way print shows it, print_value() writes that to stdout right away,
+ * in order with printf, for debugging output.
+ */
+int write_value      (output_t* out, value_t value);
 int print_value      (value_t value);
 
 #endif
\ No newline at end of file
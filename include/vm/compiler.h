@@ -7,6 +7,7 @@
 #include "vm/scanner.h"
 
 #include "value/object/function.h"
+#include "value/object/module.h"
 
 typedef struct struct_parser {
     token_t current;
@@ -49,6 +50,8 @@ typedef struct {
     token_t name;
     int depth;
     bool is_captured;
+    // assignments to immutable locals are rejected while compiling
+    bool mutable;
 } local_t;
 
 typedef struct {
@@ -76,6 +79,8 @@ typedef struct __compiler {
     uint8_t local_count;
     uint8_t loop_count;
     uint8_t scope_depth;
+    // offset of the last OP_CALL or OP_INVOKE emitted, a return right after it turns it into a tail call
+    int last_call;
 } compiler_t;
 
 typedef struct __class_compiler {
@@ -84,7 +89,16 @@ typedef struct __class_compiler {
 } class_compiler_t;
 
 
-object_function_t* compile(const char* source);
+/*
+ * Compiles 'source' into the top level function of 'module', every function it contains resolves globals in the module.
+ */
+object_function_t* compile(const char* source, object_module_t* module);
+/*
+ * Intrinsics are numbered in the order of their opcodes, starting at OP_SQRT.
+ * Returns the number of the intrinsic called 'name', or -1 if there is none.
+ */
+int find_intrinsic(const char* name, int length);
+const char* intrinsic_name(int intrinsic);
 void mark_compiler_roots();
 
 #endif
\ No newline at end of file
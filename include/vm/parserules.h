@@ -21,17 +21,21 @@ void _index     (bool);
 void _this      (bool);
 void _super     (bool);
 void list       (bool);
+void map        (bool);
 void lambda     (bool);
+void _yield     (bool);
+void _resume    (bool);
 
 parse_rule_t rules[] = {
 
     [TOKEN_LEFT_PAREN]     = {grouping, call,    PREC_CALL},
     [TOKEN_RIGHT_PAREN]    = {NULL,     NULL,    PREC_NONE},
-    [TOKEN_LEFT_BRACE]     = {NULL,     NULL,    PREC_NONE},
+    [TOKEN_LEFT_BRACE]     = {map,      NULL,    PREC_NONE},
     [TOKEN_RIGHT_BRACE]    = {NULL,     NULL,    PREC_NONE},
     [TOKEN_LEFT_SQUARE]    = {list,     _index,  PREC_CALL},
     [TOKEN_RIGHT_SQUARE]   = {NULL,     NULL,    PREC_NONE},
     [TOKEN_COMMA]          = {NULL,     NULL,    PREC_NONE},
+    [TOKEN_COLON]          = {NULL,     NULL,    PREC_NONE},
     [TOKEN_DOT]            = {NULL,     dot,     PREC_CALL},
     [TOKEN_MINUS]          = {unary,    binary,  PREC_TERM},
     [TOKEN_PLUS]           = {NULL,     binary,  PREC_TERM},
@@ -74,6 +78,9 @@ parse_rule_t rules[] = {
     [TOKEN_TRUE]           = {literal,  NULL,    PREC_NONE},
     [TOKEN_VAR]            = {NULL,     NULL,    PREC_NONE},
     [TOKEN_WHILE]          = {NULL,     NULL,    PREC_NONE},
+    [TOKEN_IMPORT]         = {NULL,     NULL,    PREC_NONE},
+    [TOKEN_YIELD]          = {_yield,   NULL,    PREC_NONE},
+    [TOKEN_RESUME]         = {_resume,  NULL,    PREC_NONE},
     [TOKEN_ERROR]          = {NULL,     NULL,    PREC_NONE},
     [TOKEN_EOF]            = {NULL,     NULL,    PREC_NONE},
 
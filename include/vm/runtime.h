@@ -11,12 +11,29 @@
 #include "value/object.h"
 
 #include "value/native/clock.h"
+#include "value/native/bench.h"
 #include "value/native/type.h"
+#include "value/native/list.h"
+#include "value/native/math.h"
+#include "value/native/array.h"
+#include "value/native/parallel.h"
+#include "value/native/isolate.h"
+#include "value/native/fiber.h"
+#include "value/native/io.h"
+#include "value/native/file.h"
+#include "value/native/map.h"
 
 #include "value/object/function.h"
 #include "value/object/string.h"
+#include "value/object/rope.h"
 #include "value/object/class.h"
 #include "value/object/list.h"
+#include "value/object/array.h"
+#include "value/object/module.h"
+#include "value/object/channel.h"
+#include "value/object/fiber.h"
+#include "value/object/reader.h"
+#include "value/object/map.h"
 
 #include "value/primitive/float.h"
 #include "value/primitive/integer.h"
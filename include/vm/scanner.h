@@ -6,7 +6,7 @@ typedef enum {
     TOKEN_LEFT_PAREN, TOKEN_RIGHT_PAREN,
     TOKEN_LEFT_BRACE, TOKEN_RIGHT_BRACE,
     TOKEN_LEFT_SQUARE, TOKEN_RIGHT_SQUARE,
-    TOKEN_COMMA, TOKEN_DOT, TOKEN_MINUS, TOKEN_PLUS,
+    TOKEN_COMMA, TOKEN_COLON, TOKEN_DOT, TOKEN_MINUS, TOKEN_PLUS,
     TOKEN_SEMICOLON, TOKEN_SLASH, TOKEN_STAR,
     TOKEN_PERCENT, TOKEN_AMPERSAND, TOKEN_PIPE, TOKEN_CAP,
 
@@ -26,7 +26,8 @@ typedef enum {
     TOKEN_FOR, TOKEN_FUN, TOKEN_LAMBDA, TOKEN_IF,
     TOKEN_NIL, TOKEN_OR, TOKEN_RETURN, TOKEN_SUPER,
     TOKEN_THIS, TOKEN_TRUE, TOKEN_VAR, TOKEN_WHILE, TOKEN_MUT,
-    TOKEN_BREAK, TOKEN_CONTINUE,
+    TOKEN_BREAK, TOKEN_CONTINUE, TOKEN_IMPORT,
+    TOKEN_YIELD, TOKEN_RESUME,
     TOKEN_PRINT, TOKEN_PRINTLN,
 
     TOKEN_ERROR, TOKEN_EOF
@@ -37,6 +38,10 @@ typedef struct {
     const char* start;
     int length;
     int line;
+    /*
+     * hash_bytes() of an identifier or keyword, or of a string literal without its quotes, 0 for other tokens
+     */
+    uint32_t hash;
 } token_t;
 
 void init_scanner(const char* source);
@@ -4,47 +4,78 @@
 #include "utils/linklist.h"
 #include "utils/table.h"
 #include "utils/stack.h"
+#include "utils/output.h"
 
 #include "value/value.h"
 #include "value/object/function.h"
+#include "value/object/module.h"
+#include "value/object/fiber.h"
 
 #include "basic/chunk.h"
 
-#define FRAMES_MAX 128
-#define STACK_MAX (FRAMES_MAX * UINT8_MAX)
+#include "component/eventloop.h"
 
-typedef struct {
-    bool mutable;
-} var_metadata_t;
-
-typedef struct {
-    object_closure_t *closure;
-    uint8_t* ip;
-    value_t* slots;
-    var_metadata_t* local_meta;
-} callframe_t;
+#define NATIVE_ERROR_MAX 256
 
 typedef struct {
-    callframe_t    frames [FRAMES_MAX];
+    // the running call stack, copied from 'root' or from the running fiber
+    callframe_t*    frames;
     int frame_count;
+    int frame_capacity;
 
-    value_t        stack  [STACK_MAX];
-    var_metadata_t local  [STACK_MAX];
+    value_t*        stack;
     value_t* stack_top;
+    int stack_capacity;
+    list_t* open_upvalues;
+    // depth limit of every call stack
+    int frames_max;
+
+    // the running fiber, NULL while the root call stack runs
+    object_fiber_t* fiber;
+    call_stack_t root;
+    // schedules the tasks, it runs after the top level code returns
+    event_loop_t loop;
 
     object_string_t *init_string;
     // the string table is a value table, but without values
     table_t strings;
-    // the globals table is a var table
+    // the globals table is a var table, it holds the natives every module can see
     table_t globals;
+    // This is a value table, canonical path -> module, a module is compiled and run once
+    table_t modules;
+    // the module of the script given to interpret()
+    object_module_t* main;
     list_t obj;
-    list_t open_upvalues;
+    // objects created by the operation being executed, see merge_temporary()
+    list_t temporary_objs;
 
     // gray stack
     clox_stack_t gray_stack;
+    // objects allocated since the VM was created, collected or not
+    uint64_t objects_allocated;
+
+    /*
+     * new objects are created while compiling, but they can be wiped out by a following reallocate,
+     * so the compiler turns the garbage collector off while it runs
+     */
+    bool do_garbage_collector;
+
+    // message left by the last failing native function
+    char native_error[NATIVE_ERROR_MAX];
+
+    // 'frame_base' of the running call stack, apart from the fields above, placing it among them slowed calls down
+    int frame_base;
+
+    // what print writes, handed to stdout when full, after every line on a terminal, and when interpret() returns
+    output_t output;
 } vm_t;
 
-extern vm_t vm;
+/*
+ * The VM the calling thread is running. Every VM is an independent interpreter with its own heap,
+ * string table and globals, so different threads can each run their own VM at the same time.
+ * A VM must only be used by one thread at a time.
+ */
+extern _Thread_local vm_t* vm;
 
 typedef enum {
     INTERPRET_OK,
@@ -52,13 +83,46 @@ typedef enum {
     INTERPRET_RUNTIME_ERROR
 } interpret_result_t;
 
-void init_vm();
-void free_vm();
-interpret_result_t interpret(const char* source);
+vm_t* new_vm();
+void  free_vm(vm_t* machine);
+/*
+ * Makes 'machine' the VM of the calling thread and returns the one it replaces.
+ * interpret() switches for the duration of the call, code using the runtime directly has to switch first.
+ */
+vm_t* switch_vm(vm_t* machine);
+
+interpret_result_t interpret(vm_t* machine, const char* source);
+/*
+ * Like interpret(), imports in 'source' are resolved relative to the directory of 'path'.
+ */
+interpret_result_t interpret_file(vm_t* machine, const char* path, const char* source);
+/*
+ * Calls the value pushed below the 'arg_count' arguments on top of the stack of an idle 'machine'.
+ * On success the result replaces them on the stack, on a runtime error the stack is reset.
+ */
+interpret_result_t interpret_call(vm_t* machine, int arg_count);
+/*
+ * Lets a native call the value pushed below the 'arg_count' arguments on top of the stack,
+ * the result replaces them once the call has returned. Fibers resumed meanwhile work as usual, but
+ * the call itself cannot yield, and tasks block on I/O instead of waiting in the event loop.
+ * On a runtime error the error is reported and the stack unwound, the native returns NONE_VAL right away.
+ */
+bool call_from_native(int arg_count);
+/*
+ * Defines or redefines a global of 'module'. Every global of a module is defined through it,
+ * so the module knows which intrinsics its globals shadow.
+ */
+void define_global(object_module_t* module, object_string_t* name, value_t value, bool mutable);
 
 void    push(value_t value);
 value_t pop();
 
+/*
+ * Natives report failures by returning the result of native_error(),
+ * the vm then raises a runtime error carrying the formatted message.
+ */
+value_t native_error(const char* format, ...);
+
 // housekeeping
 void remove_unused_strings();
 
@@ -2,13 +2,13 @@
 
 #include "constant.h"
 #include "common.h"
-#include "switch.h"
 
 #include "basic/memory.h"
 
 #include "vm/runtime.h"
 #include "vm/compiler.h"
 #include "component/vartable.h"
+#include "component/valuetable.h"
 #include "component/graystack.h"
 
 #ifdef DEBUG_LOG_GC
@@ -19,7 +19,7 @@
 
 
 static void mark_roots() {
-    for (value_t* slot = vm.stack; slot < vm.stack_top; slot++) {
+    for (value_t* slot = vm->stack; slot < vm->stack_top; slot++) {
 #ifdef DEBUG_LOG_GC
         printf("Mark stack value ");
         print_value(*slot);
@@ -28,22 +28,30 @@ static void mark_roots() {
         mark_value(*slot);
     }
 
-    for (int i = 0; i < vm.frame_count; ++i) {
-        mark_object((object_t*)vm.frames[i].closure);
+    for (int i = 0; i < vm->frame_count; ++i) {
+        mark_object((object_t*)vm->frames[i].closure);
     }
 
     object_upvalue_t * iter = NULL;
-    list_iterate_begin(object_upvalue_t, link, &vm.open_upvalues, iter) {
+    list_iterate_begin(object_upvalue_t, link, vm->open_upvalues, iter) {
         mark_object((object_t*)iter);
     } list_iterate_end();
 
+    // while a fiber runs, the root call stack is parked
+    mark_object((object_t*)vm->fiber);
+    if (vm->fiber != NULL)
+        mark_call_stack(&vm->root);
+    mark_event_loop(&vm->loop);
+
     mark_compiler_roots();
-    mark_object((object_t*)vm.init_string);
-    mark_table_var(&vm.globals);
+    mark_object((object_t*)vm->init_string);
+    mark_table_var(&vm->globals);
+    mark_object((object_t*)vm->main);
+    mark_table_value(&vm->modules);
 }
 static void trace_references() {
-    while (vm.gray_stack.count) {
-        object_t* object = pop_gray_stack(&vm.gray_stack);
+    while (vm->gray_stack.count) {
+        object_t* object = pop_gray_stack(&vm->gray_stack);
         blacken_object(object);
     }
 }
@@ -53,7 +61,7 @@ void* reallocate(void* pointer, size_t old_size, size_t new_size) {
      * The VM needs a global switch to decide when to do garbage collection.
      * Garbage collection at compile time might lead to nullptr issues on constant strings.
      */
-    if (do_garbage_collector && new_size > old_size) {
+    if (vm->do_garbage_collector && new_size > old_size) {
 #ifdef DEBUG_STRESS_GC
         collect_garbage();
 #endif
@@ -79,7 +87,7 @@ void mark_object(object_t* object) {
 #endif
     object->is_marked = true;
 
-    push_gray_stack(&vm.gray_stack, object);
+    push_gray_stack(&vm->gray_stack, object);
 }
 
 void mark_value(value_t value) {
@@ -98,17 +106,20 @@ static void sweep() {
     object_t* iter = NULL;
     object_t* objects_to_sweep[OBJECT_MAX];
     int count = 0;
-    list_iterate_begin(object_t, link, &vm.obj, iter) {
+    list_iterate_begin(object_t, link, &vm->obj, iter) {
 #ifdef DEBUG_PRINT_OBJECT
         printf("object iterated %p, value ", iter);
         print_value(OBJECT_VAL(iter));
         printf(", marked?: %d, prev: %p, next: %p, ", iter->is_marked, iter->link.l_prev, iter->link.l_next);
         printf("\n");
 #endif
-        if (count == OBJECT_MAX) {
-            goto STOP_LOOP;
-        }
+        /*
+         *  Past OBJECT_MAX the walk goes on to clear the marks,
+         *  an object left marked would not be traced by the next collection.
+         */
         if (!iter->is_marked) {
+            if (count == OBJECT_MAX)
+                continue;
 #ifdef DEBUG_LOG_GC
             printf("Found a unmarked object %p, type %d, value ", iter, iter->type);
             print_value(OBJECT_VAL(iter));
@@ -119,7 +130,10 @@ static void sweep() {
             iter->is_marked = false;
         }
     } list_iterate_end();
-    STOP_LOOP:;
+    // objects created by the current operation are never swept, but they are marked too
+    list_iterate_begin(object_t, link, &vm->temporary_objs, iter) {
+        iter->is_marked = false;
+    } list_iterate_end();
 #ifdef DEBUG_LOG_GC
     printf("%d objects need to be freed.\n", count);
 #endif
@@ -133,7 +147,7 @@ static void sweep() {
         list_remove(&obj->link);
         free_object(obj);
     }
-    list_iterate_begin(object_t, link, &vm.obj, iter) {
+    list_iterate_begin(object_t, link, &vm->obj, iter) {
 #ifdef DEBUG_PRINT_OBJECT
         printf("object iterated %p, value ", iter);
         print_value(OBJECT_VAL(iter));
@@ -151,7 +165,7 @@ void collect_garbage() {
 #ifdef DEBUG_PRINT_OBJECT
     printf("-- object status before marking --\n");
     object_t* iter = NULL;
-    list_iterate_begin(object_t, link, &vm.obj, iter) {
+    list_iterate_begin(object_t, link, &vm->obj, iter) {
         printf("object iterated %p, value ", iter);
         print_value(OBJECT_VAL(iter));
         printf(", marked?: %d, prev: %p, next: %p, ", iter->is_marked, iter->link.l_prev, iter->link.l_next);
@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+
+#include "utils/hash.h"
+#include "utils/trie.h"
+#include "component/keyword.h"
+#include "vm/vm.h"
+#include "vm/scanner.h"
+#include "vm/compiler.h"
+#include "value/object/string.h"
+
+/*
+ * Micro benchmarks for the front end. Results go to stderr, stdout is discarded since
+ * the compiler disassembles every chunk while DEBUG_PRINT_CODE is defined.
+ *
+ *   bench_clox [rounds]
+ */
+
+#define BENCH_FUNCTIONS 2000
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// the byte at a time FNV-1a the interning table used before hash_bytes()
+static uint32_t hash_fnv1a(const char* key, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+typedef uint32_t (*hash_fn_t)(const char* key, int length);
+
+/*
+ * A script shaped like ordinary code: globals, functions with parameters and locals,
+ * field accesses and string literals, with identifiers of typical lengths.
+ * 'documented' puts a comment block in front of every function and a long message in its body,
+ * the kind of long runs the block scanner is for.
+ */
+static char* generate_source(size_t* size, bool documented) {
+    static const char* words[] = {
+        "i", "n", "count", "total", "value", "index", "result", "buffer_size",
+        "left", "right", "node", "next_item", "accumulator", "x", "y", "offset",
+    };
+    size_t capacity = 1 << 20, length = 0;
+    char* source = malloc(capacity);
+    for (int f = 0; f < BENCH_FUNCTIONS; f++) {
+        if (capacity - length < 1024) {
+            capacity *= 2;
+            source = realloc(source, capacity);
+        }
+        const char* a = words[f % 16];
+        const char* b = words[(f * 7 + 3) % 16];
+        if (documented) {
+            length += sprintf(source + length,
+                "// compute_%s_%d folds '%s' into the running total while walking from zero to '%s'.\n"
+                "// The result is written back to the matching global so later passes can pick it up.\n"
+                "//\n"
+                "//        returns a short description of the two operands it was given.\n",
+                b, f, a, b);
+        }
+        length += sprintf(source + length,
+            "var mut %s_global_%d = %d;\n"
+            "fun compute_%s_%d(%s, %s) {\n"
+            "    var mut %s_local = %s + %s * %d;\n"
+            "    for (var mut k = 0; k < %s; k = k + 1) {\n"
+            "        %s_local = %s_local + k;\n"
+            "    }\n"
+            "    %s_global_%d = %s_local;\n"
+            "%s"
+            "    return \"%s and %s\";\n"
+            "}\n",
+            a, f, f,
+            b, f, a, b,
+            a, a, b, f,
+            b,
+            a, a,
+            a, f, a,
+            documented ? "    var message = \"finished accumulating the local value into the global slot for this function\";\n" : "",
+            a, b);
+    }
+    *size = length;
+    return source;
+}
+
+static void bench_hash(hash_fn_t hash, const char* name, const char** keys, const int* lengths, int n) {
+    int repeat = 200;
+    uint32_t sink = 0;
+    double start = now();
+    for (int r = 0; r < repeat; r++)
+        for (int i = 0; i < n; i++)
+            sink += hash(keys[i], lengths[i]);
+    double elapsed = now() - start;
+    fprintf(stderr, "  %-12s %6.2f ns/key   (%u)\n", name, elapsed * 1e9 / ((double)repeat * n), sink & 1);
+}
+
+/*
+ * Identifier classification: the constant perfect hash against the heap allocated keyword trie
+ * the scanner walked before. The trie only indexes 'a'..'z', so words with other characters are skipped.
+ */
+static void bench_keywords(const char** words, const int* lengths, int n) {
+    static const char* keywords[] = {
+        "and", "class", "this", "else", "if", "or", "super", "mut", "var", "fun", "lambda",
+        "print", "println", "while", "for", "return", "break", "continue", "nil", "true", "false",
+    };
+    trie_t trie;
+    trie_init(&trie);
+    trie_node_init(trie.root);
+    for (int i = 0; i < 21; i++)
+        trie_insert(&trie, keywords[i]);
+
+    int lower = 0;
+    const char** lower_words = malloc(sizeof(char*) * n);
+    int* lower_lengths = malloc(sizeof(int) * n);
+    for (int i = 0; i < n; i++) {
+        bool only_lower = true;
+        for (int j = 0; j < lengths[i]; j++)
+            only_lower &= words[i][j] >= 'a' && words[i][j] <= 'z';
+        if (only_lower) {
+            lower_words[lower] = words[i];
+            lower_lengths[lower++] = lengths[i];
+        }
+    }
+
+    int repeat = 200;
+    long found = 0;
+    double start = now();
+    for (int r = 0; r < repeat; r++)
+        for (int i = 0; i < lower; i++)
+            found += __trie_find(&trie, lower_words[i], lower_lengths[i]) != NULL;
+    double trie_time = now() - start;
+
+    start = now();
+    for (int r = 0; r < repeat; r++)
+        for (int i = 0; i < lower; i++)
+            found += keyword_type(lower_words[i], lower_lengths[i]) != TOKEN_IDENTIFIER;
+    double hash_time = now() - start;
+
+    fprintf(stderr, "\nclassifying %d words (%ld keywords)\n", lower, found / (2 * repeat));
+    fprintf(stderr, "  %-12s %6.2f ns/word\n", "trie", trie_time * 1e9 / ((double)repeat * lower));
+    fprintf(stderr, "  %-12s %6.2f ns/word\n", "perfect hash", hash_time * 1e9 / ((double)repeat * lower));
+
+    trie_free(&trie);
+    free(lower_words);
+    free(lower_lengths);
+}
+
+/*
+ * Probe lengths of every key in an open addressed table of 'capacity' slots, the layout used by vm->strings.
+ */
+static void probe_lengths(hash_fn_t hash, const char* name, object_string_t** keys, int n, int capacity) {
+    char* used = calloc(capacity, 1);
+    long total = 0;
+    int longest = 0;
+    for (int i = 0; i < n; i++) {
+        uint32_t index = hash(keys[i]->chars, keys[i]->length) & (capacity - 1);
+        int probes = 1;
+        while (used[index]) {
+            index = (index + 1) & (capacity - 1);
+            probes++;
+        }
+        used[index] = 1;
+        total += probes;
+        if (probes > longest) longest = probes;
+    }
+    fprintf(stderr, "  %-12s average %.3f   longest %d\n", name, (double)total / n, longest);
+    free(used);
+}
+
+int main(int argc, const char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    if (freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    launch_scanner();
+    switch_vm(new_vm());
+    // interned strings must survive between rounds, and DEBUG_STRESS_GC would dominate every timing
+    vm->do_garbage_collector = false;
+
+    size_t size;
+    char* source = generate_source(&size, false);
+    fprintf(stderr, "source: %zu bytes, %d functions\n", size, BENCH_FUNCTIONS);
+
+    // collect every identifier and string literal of the script
+    // and every word, identifier or keyword, for the classification benchmark
+    int n = 0, capacity = 1024, word_count = 0, word_capacity = 1024;
+    const char** keys = malloc(sizeof(char*) * capacity);
+    int* lengths = malloc(sizeof(int) * capacity);
+    const char** words = malloc(sizeof(char*) * word_capacity);
+    int* word_lengths = malloc(sizeof(int) * word_capacity);
+    int tokens = 0;
+    init_scanner(source);
+    for (token_t token = scan_token(); token.type != TOKEN_EOF; token = scan_token()) {
+        tokens++;
+        if (token.type == TOKEN_IDENTIFIER || (token.type >= TOKEN_AND && token.type <= TOKEN_PRINTLN)) {
+            if (word_count == word_capacity) {
+                word_capacity *= 2;
+                words = realloc(words, sizeof(char*) * word_capacity);
+                word_lengths = realloc(word_lengths, sizeof(int) * word_capacity);
+            }
+            words[word_count] = token.start;
+            word_lengths[word_count++] = token.length;
+        }
+        if (token.type != TOKEN_IDENTIFIER && token.type != TOKEN_STRING) continue;
+        if (n == capacity) {
+            capacity *= 2;
+            keys = realloc(keys, sizeof(char*) * capacity);
+            lengths = realloc(lengths, sizeof(int) * capacity);
+        }
+        bool literal = token.type == TOKEN_STRING;
+        keys[n] = token.start + literal;
+        lengths[n++] = token.length - 2 * literal;
+    }
+
+    fprintf(stderr, "\nhashing %d identifiers and literals\n", n);
+    bench_hash(hash_fnv1a, "fnv-1a", keys, lengths, n);
+    bench_hash(hash_bytes, "hash_bytes", keys, lengths, n);
+
+    bench_keywords(words, word_lengths, word_count);
+
+    double start = now();
+    for (int r = 0; r < rounds; r++) {
+        init_scanner(source);
+        while (scan_token().type != TOKEN_EOF);
+    }
+    double elapsed = now() - start;
+    fprintf(stderr, "\nscan           %8.2f MB/s, %.1f ns/token\n",
+            size * rounds / elapsed / 1e6, elapsed * 1e9 / ((double)rounds * tokens));
+
+    size_t documented_size;
+    char* documented = generate_source(&documented_size, true);
+    start = now();
+    for (int r = 0; r < rounds; r++) {
+        init_scanner(documented);
+        while (scan_token().type != TOKEN_EOF);
+    }
+    elapsed = now() - start;
+    fprintf(stderr, "scan commented %8.2f MB/s (%zu bytes)\n", documented_size * rounds / elapsed / 1e6, documented_size);
+    free(documented);
+
+    start = now();
+    for (int r = 0; r < rounds; r++) {
+        init_scanner(source);
+        for (token_t token = scan_token(); token.type != TOKEN_EOF; token = scan_token()) {
+            if (token.type == TOKEN_IDENTIFIER)
+                copy_string_hashed(token.start, token.length, token.hash);
+        }
+    }
+    elapsed = now() - start;
+    fprintf(stderr, "scan + intern  %8.2f MB/s\n", size * rounds / elapsed / 1e6);
+
+    start = now();
+    for (int r = 0; r < rounds; r++) {
+        if (compile(source, vm->main) == NULL) {
+            fprintf(stderr, "compile error\n");
+            return 1;
+        }
+        merge_temporary();
+    }
+    elapsed = now() - start;
+    fprintf(stderr, "compile        %8.2f MB/s (including disassembly)\n", size * rounds / elapsed / 1e6);
+
+    int interned = 0;
+    object_string_t** strings = malloc(sizeof(object_string_t*) * vm->strings.count);
+    for (int i = 0; i < vm->strings.capacity; i++) {
+        if (vm->strings.entries[i].key != NULL)
+            strings[interned++] = vm->strings.entries[i].key;
+    }
+    fprintf(stderr, "\nprobe lengths of %d interned strings in %d slots\n", interned, vm->strings.capacity);
+    probe_lengths(hash_fnv1a, "fnv-1a", strings, interned, vm->strings.capacity);
+    probe_lengths(hash_bytes, "hash_bytes", strings, interned, vm->strings.capacity);
+
+    free(strings);
+    free(keys);
+    free(words);
+    free(word_lengths);
+    free(lengths);
+    free(source);
+    return 0;
+}
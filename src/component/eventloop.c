@@ -0,0 +1,308 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "basic/memory.h"
+#include "component/eventloop.h"
+#include "vm/runtime.h"
+
+#define EPOLL_EVENTS_MAX 64
+
+static int64_t now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static void* grow(void* pointer, int* capacity, int needed, size_t size) {
+    int old_capacity = *capacity;
+    while (*capacity < needed)
+        *capacity = GROW_CAPACITY(*capacity);
+    pointer = realloc(pointer, size * *capacity);
+    if (pointer == NULL) {
+        __CLOX_ERROR("Not enough memory for the event loop.");
+    }
+    memset((char*)pointer + size * old_capacity, 0, size * (*capacity - old_capacity));
+    return pointer;
+}
+
+void init_event_loop(event_loop_t* loop) {
+    memset(loop, 0, sizeof(event_loop_t));
+    loop->epoll_fd = -1;
+}
+
+void free_io_operation(io_operation_t* operation) {
+    free(operation->data);
+    operation->data = NULL;
+}
+
+void free_event_loop(event_loop_t* loop) {
+    for (int fd = 0; fd < loop->watch_capacity; fd++) {
+        free_io_operation(&loop->watches[fd].reader.operation);
+        free_io_operation(&loop->watches[fd].writer.operation);
+    }
+    free(loop->watches);
+    free(loop->timers);
+    free(loop->ready);
+    if (loop->epoll_fd >= 0)
+        close(loop->epoll_fd);
+    init_event_loop(loop);
+}
+
+void mark_event_loop(event_loop_t* loop) {
+    for (int i = 0; i < loop->ready_count; i++) {
+        ready_task_t* ready = &loop->ready[(loop->ready_head + i) % loop->ready_capacity];
+        mark_object((object_t*)ready->task);
+        mark_value(ready->value);
+    }
+    for (int i = 0; i < loop->timer_count; i++)
+        mark_object((object_t*)loop->timers[i].task);
+    for (int fd = 0; loop->waiting && fd < loop->watch_capacity; fd++) {
+        mark_object((object_t*)loop->watches[fd].reader.task);
+        mark_object((object_t*)loop->watches[fd].writer.task);
+    }
+}
+
+void loop_ready(event_loop_t* loop, object_fiber_t* task, value_t value) {
+    if (loop->ready_count == loop->ready_capacity) {
+        int old_capacity = loop->ready_capacity;
+        loop->ready = grow(loop->ready, &loop->ready_capacity, old_capacity + 1, sizeof(ready_task_t));
+        // unwrap the ring, the tasks before the head move after the old end
+        for (int i = 0; i < loop->ready_head; i++)
+            loop->ready[old_capacity + i] = loop->ready[i];
+    }
+    int tail = (loop->ready_head + loop->ready_count++) % loop->ready_capacity;
+    loop->ready[tail] = (ready_task_t) {task, value};
+}
+
+/******************** TIMERS *********************/
+
+static bool timer_before(loop_timer_t* a, loop_timer_t* b) {
+    return a->deadline < b->deadline || (a->deadline == b->deadline && a->sequence < b->sequence);
+}
+
+void loop_sleep(event_loop_t* loop, object_fiber_t* task, double milliseconds) {
+    if (loop->timer_count == loop->timer_capacity)
+        loop->timers = grow(loop->timers, &loop->timer_capacity, loop->timer_count + 1, sizeof(loop_timer_t));
+    int64_t delay = milliseconds > 0 ? (int64_t)(milliseconds * 1000000) : 0;
+    loop_timer_t timer = {now() + delay, loop->timer_sequence++, task};
+
+    int child = loop->timer_count++;
+    while (child > 0) {
+        int parent = (child - 1) / 2;
+        if (!timer_before(&timer, &loop->timers[parent]))
+            break;
+        loop->timers[child] = loop->timers[parent];
+        child = parent;
+    }
+    loop->timers[child] = timer;
+    task->state = FIBER_WAITING;
+}
+
+static void pop_timer(event_loop_t* loop) {
+    loop_timer_t last = loop->timers[--loop->timer_count];
+    int parent = 0;
+    for (;;) {
+        int child = parent * 2 + 1;
+        if (child >= loop->timer_count)
+            break;
+        if (child + 1 < loop->timer_count && timer_before(&loop->timers[child + 1], &loop->timers[child]))
+            child++;
+        if (!timer_before(&loop->timers[child], &last))
+            break;
+        loop->timers[parent] = loop->timers[child];
+        parent = child;
+    }
+    loop->timers[parent] = last;
+}
+
+static void fire_timers(event_loop_t* loop) {
+    int64_t time = now();
+    while (loop->timer_count && loop->timers[0].deadline <= time) {
+        object_fiber_t* task = loop->timers[0].task;
+        pop_timer(loop);
+        loop_ready(loop, task, NIL_VAL);
+    }
+}
+
+/******************** DESCRIPTORS *********************/
+
+static io_waiter_t* waiter_of(io_watch_t* watch, io_kind_t kind) {
+    return kind == IO_READ || kind == IO_ACCEPT ? &watch->reader : &watch->writer;
+}
+
+// keeps the descriptor registered with epoll for exactly the directions tasks wait on
+static bool update_interest(event_loop_t* loop, int fd) {
+    io_watch_t* watch = &loop->watches[fd];
+    uint32_t events = (watch->reader.task ? EPOLLIN : 0) | (watch->writer.task ? EPOLLOUT : 0);
+    if (events == watch->events)
+        return true;
+
+    struct epoll_event event = {.events = events, .data.fd = fd};
+    int result;
+    if (events == 0)
+        result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    else if (watch->events == 0)
+        result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    else
+        result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    watch->events = result == 0 ? events : 0;
+    return result == 0 || events == 0;
+}
+
+static void wake(event_loop_t* loop, io_waiter_t* waiter, value_t value) {
+    object_fiber_t* task = waiter->task;
+    free_io_operation(&waiter->operation);
+    waiter->task = NULL;
+    loop->waiting--;
+    loop_ready(loop, task, value);
+}
+
+bool loop_wait(event_loop_t* loop, object_fiber_t* task, int fd, io_operation_t operation) {
+    if (fd >= loop->watch_capacity)
+        loop->watches = grow(loop->watches, &loop->watch_capacity, fd + 1, sizeof(io_watch_t));
+    io_waiter_t* waiter = waiter_of(&loop->watches[fd], operation.kind);
+    if (waiter->task != NULL)
+        return false;
+
+    waiter->task = task;
+    waiter->operation = operation;
+    loop->waiting++;
+    task->state = FIBER_WAITING;
+    if (loop->epoll_fd < 0)
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    // a descriptor epoll cannot watch never blocks, the task gets nil back right away
+    if (loop->epoll_fd < 0 || !update_interest(loop, fd)) {
+        wake(loop, waiter, NIL_VAL);
+        update_interest(loop, fd);
+    }
+    return true;
+}
+
+void loop_forget(event_loop_t* loop, int fd) {
+    if (fd < 0 || fd >= loop->watch_capacity)
+        return;
+    io_watch_t* watch = &loop->watches[fd];
+    if (watch->reader.task != NULL)
+        wake(loop, &watch->reader, NIL_VAL);
+    if (watch->writer.task != NULL)
+        wake(loop, &watch->writer, NIL_VAL);
+    update_interest(loop, fd);
+}
+
+static void complete(event_loop_t* loop, int fd, io_waiter_t* waiter) {
+    value_t result;
+    if (waiter->task != NULL && io_attempt(fd, &waiter->operation, &result))
+        wake(loop, waiter, result);
+}
+
+static void poll_descriptors(event_loop_t* loop, int timeout) {
+    struct epoll_event events[EPOLL_EVENTS_MAX];
+    int count = epoll_wait(loop->epoll_fd, events, EPOLL_EVENTS_MAX, timeout);
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        io_watch_t* watch = &loop->watches[fd];
+        // errors and hang ups complete the operation too, it reports them
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+            complete(loop, fd, &watch->reader);
+        if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+            complete(loop, fd, &watch->writer);
+        update_interest(loop, fd);
+    }
+}
+
+bool loop_next(event_loop_t* loop, object_fiber_t** task, value_t* value) {
+    for (;;) {
+        if (loop->ready_count) {
+            ready_task_t* ready = &loop->ready[loop->ready_head];
+            *task = ready->task;
+            *value = ready->value;
+            loop->ready_head = (loop->ready_head + 1) % loop->ready_capacity;
+            loop->ready_count--;
+            return true;
+        }
+        if (loop->timer_count == 0 && loop->waiting == 0)
+            return false;
+
+        int timeout = -1;
+        if (loop->timer_count) {
+            int64_t wait = loop->timers[0].deadline - now();
+            timeout = wait <= 0 ? 0 : (int)((wait + 999999) / 1000000);
+        }
+        if (loop->waiting) {
+            poll_descriptors(loop, timeout);
+        } else if (timeout > 0) {
+            int64_t wait = loop->timers[0].deadline - now();
+            struct timespec time = {wait / 1000000000, wait % 1000000000};
+            if (wait > 0)
+                nanosleep(&time, NULL);
+        }
+        fire_timers(loop);
+    }
+}
+
+bool io_attempt(int fd, io_operation_t* operation, value_t* result) {
+    switch (operation->kind) {
+        case IO_READ: {
+            char* buffer = malloc(operation->length);
+            if (buffer == NULL) {
+                __CLOX_ERROR("Not enough memory to read.");
+            }
+            ssize_t count;
+            do {
+                count = read(fd, buffer, operation->length);
+            } while (count < 0 && errno == EINTR);
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                free(buffer);
+                return false;
+            }
+            *result = count < 0 ? NIL_VAL : OBJECT_VAL(copy_uninterned_string(buffer, (int)count));
+            free(buffer);
+            return true;
+        }
+        case IO_WRITE:
+            while (operation->done < operation->length) {
+                ssize_t count = write(fd, operation->data + operation->done, operation->length - operation->done);
+                if (count < 0 && errno == EINTR)
+                    continue;
+                if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    return false;
+                if (count < 0) {
+                    *result = NIL_VAL;
+                    return true;
+                }
+                operation->done += (int)count;
+            }
+            *result = INT_VAL(operation->done);
+            return true;
+        case IO_ACCEPT: {
+            int client;
+            do {
+                client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            } while (client < 0 && errno == EINTR);
+            if (client < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return false;
+            *result = client < 0 ? NIL_VAL : INT_VAL(client);
+            return true;
+        }
+        case IO_CONNECT: {
+            // only attempted once the socket is writable, the connection is settled by then
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error) {
+                close(fd);
+                *result = NIL_VAL;
+            } else {
+                *result = INT_VAL(fd);
+            }
+            return true;
+        }
+    }
+    return false;
+}
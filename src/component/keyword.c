@@ -0,0 +1,59 @@
+#include <string.h>
+
+#include "component/keyword.h"
+
+typedef struct {
+    const char* name;
+    int length;
+    tokentype_t type;
+} keyword_t;
+
+/*
+ * The slots are computed at compile time from the keyword's length, first and last character.
+ * When adding a keyword make sure its slot is still free, test_clox checks every keyword round trips.
+ */
+#define KEYWORD(name, first, last, type) \
+    [KEYWORD_SLOT(sizeof(name) - 1, first, last)] = {name, sizeof(name) - 1, type}
+
+static const keyword_t keywords[KEYWORD_SLOTS] = {
+    KEYWORD("and",      'a', 'd', TOKEN_AND),
+    KEYWORD("class",    'c', 's', TOKEN_CLASS),
+    KEYWORD("this",     't', 's', TOKEN_THIS),
+    KEYWORD("else",     'e', 'e', TOKEN_ELSE),
+    KEYWORD("if",       'i', 'f', TOKEN_IF),
+    KEYWORD("or",       'o', 'r', TOKEN_OR),
+    KEYWORD("super",    's', 'r', TOKEN_SUPER),
+    KEYWORD("mut",      'm', 't', TOKEN_MUT),
+
+    KEYWORD("var",      'v', 'r', TOKEN_VAR),
+    KEYWORD("fun",      'f', 'n', TOKEN_FUN),
+    KEYWORD("lambda",   'l', 'a', TOKEN_LAMBDA),
+
+    KEYWORD("print",    'p', 't', TOKEN_PRINT),
+    KEYWORD("println",  'p', 'n', TOKEN_PRINTLN),
+
+    KEYWORD("while",    'w', 'e', TOKEN_WHILE),
+    KEYWORD("for",      'f', 'r', TOKEN_FOR),
+
+    KEYWORD("return",   'r', 'n', TOKEN_RETURN),
+    KEYWORD("break",    'b', 'k', TOKEN_BREAK),
+    KEYWORD("continue", 'c', 'e', TOKEN_CONTINUE),
+    KEYWORD("import",   'i', 't', TOKEN_IMPORT),
+    KEYWORD("yield",    'y', 'd', TOKEN_YIELD),
+    KEYWORD("resume",   'r', 'e', TOKEN_RESUME),
+
+    KEYWORD("nil",      'n', 'l', TOKEN_NIL),
+    KEYWORD("true",     't', 'e', TOKEN_TRUE),
+    KEYWORD("false",    'f', 'e', TOKEN_FALSE),
+};
+
+#undef KEYWORD
+
+tokentype_t keyword_type(const char* start, int length) {
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
+        return TOKEN_IDENTIFIER;
+    const keyword_t* keyword = &keywords[KEYWORD_SLOT(length, start[0], start[length - 1])];
+    if (keyword->length == length && !memcmp(keyword->name, start, length))
+        return keyword->type;
+    return TOKEN_IDENTIFIER;
+}
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "constant.h"
+
+#include "component/message.h"
+#include "vm/runtime.h"
+#include "value/object/channel.h"
+
+static bool pack(value_t value, message_t* message, int depth);
+
+static void free_function(message_function_t* function) {
+    free_message(&function->name);
+    for (int i = 0; i < function->constant_count; i++)
+        free_message(&function->constants[i]);
+    free(function->constants);
+    free(function->code);
+    free(function->lines);
+    free(function);
+}
+
+static bool pack_function(object_function_t* function, message_t* message, int depth) {
+    message_function_t* packed = calloc(1, sizeof(message_function_t));
+    if (packed == NULL)
+        return false;
+    packed->arity = function->arity;
+    packed->max_slots = function->max_slots;
+    packed->upvalue_count = function->upvalue_count;
+    memcpy(packed->upvalues, function->upvalues, sizeof(upvalue_t) * function->upvalue_count);
+    packed->name.kind = MESSAGE_VALUE;
+    packed->name.value = NIL_VAL;
+
+    chunk_t* chunk = &function->chunk;
+    packed->code_count = chunk->count;
+    packed->code = malloc(chunk->count ? chunk->count : 1);
+    packed->lines = malloc(sizeof(int) * (chunk->count ? chunk->count : 1));
+    packed->constants = calloc(chunk->constants.count ? chunk->constants.count : 1, sizeof(message_t));
+    if (packed->code == NULL || packed->lines == NULL || packed->constants == NULL) {
+        free_function(packed);
+        return false;
+    }
+    memcpy(packed->code, chunk->code, chunk->count);
+    memcpy(packed->lines, chunk->lines, sizeof(int) * chunk->count);
+
+    if (function->name != NULL && !pack(OBJECT_VAL(function->name), &packed->name, depth + 1)) {
+        free_function(packed);
+        return false;
+    }
+    for (int i = 0; i < chunk->constants.count; i++) {
+        if (!pack(chunk->constants.values[i], &packed->constants[i], depth + 1)) {
+            free_function(packed);
+            return false;
+        }
+        packed->constant_count = i + 1;
+    }
+    message->as.function = packed;
+    return true;
+}
+
+static bool pack(value_t value, message_t* message, int depth) {
+    if (depth > MESSAGE_DEPTH_MAX)
+        return false;
+
+    message->value = NIL_VAL;
+    message->count = 0;
+    if (!IS_OBJECT(value)) {
+        message->kind = MESSAGE_VALUE;
+        message->value = value;
+        return true;
+    }
+
+    switch (OBJ_TYPE(value)) {
+        case OBJ_STRING:
+        case OBJ_ROPE: {
+            object_string_t* string = AS_STRING(flatten_value(value));
+            message->kind = MESSAGE_STRING;
+            message->count = string->length;
+            message->as.chars = malloc(string->length + 1);
+            if (message->as.chars == NULL)
+                return false;
+            memcpy(message->as.chars, string->chars, string->length + 1);
+            return true;
+        }
+        case OBJ_LIST: {
+            object_list_t* list = AS_LIST(value);
+            message->kind = MESSAGE_LIST;
+            message->as.items = calloc(list->count ? list->count : 1, sizeof(message_t));
+            if (message->as.items == NULL)
+                return false;
+            for (int i = 0; i < list->count; i++) {
+                value_t element;
+                get_list_value(list, i, &element);
+                if (!pack(element, &message->as.items[i], depth + 1)) {
+                    free_message(message);
+                    return false;
+                }
+                message->count = i + 1;
+            }
+            return true;
+        }
+        case OBJ_ARRAY: {
+            object_array_t* array = AS_ARRAY(value);
+            size_t size = array_data_size(array->type, array->count);
+            message->kind = MESSAGE_ARRAY;
+            message->count = array->count;
+            message->as.array.type = array->type;
+            message->as.array.data = malloc(size ? size : 1);
+            if (message->as.array.data == NULL)
+                return false;
+            memcpy(message->as.array.data, array->data, size);
+            return true;
+        }
+        case OBJ_CHANNEL:
+            message->kind = MESSAGE_CHANNEL;
+            message->as.channel = AS_CHANNEL(value)->channel;
+            retain_channel(message->as.channel);
+            return true;
+        case OBJ_CLOSURE:
+            // captured variables live on the sender's stack
+            if (AS_CLOSURE(value)->upvalue_count)
+                return false;
+            message->kind = MESSAGE_CLOSURE;
+            return pack_function(AS_CLOSURE(value)->function, message, depth);
+        case OBJ_FUNCTION:
+            message->kind = MESSAGE_FUNCTION;
+            return pack_function(AS_FUNCTION(value), message, depth);
+        default:
+            return false;
+    }
+}
+
+bool pack_message(value_t value, message_t* message) {
+    return pack(value, message, 0);
+}
+
+static object_function_t* unpack_function(message_function_t* packed) {
+    object_function_t* function = new_function();
+    push(OBJECT_VAL(function));
+    function->arity = packed->arity;
+    function->max_slots = packed->max_slots;
+    function->upvalue_count = packed->upvalue_count;
+    memcpy(function->upvalues, packed->upvalues, sizeof(upvalue_t) * packed->upvalue_count);
+    function->module = vm->main;
+    if (packed->name.kind == MESSAGE_STRING)
+        function->name = AS_STRING(unpack_message(&packed->name));
+
+    chunk_t* chunk = &function->chunk;
+    chunk->code = GROW_ARRAY(uint8_t, NULL, 0, packed->code_count);
+    chunk->lines = GROW_ARRAY(int, NULL, 0, packed->code_count);
+    memcpy(chunk->code, packed->code, packed->code_count);
+    memcpy(chunk->lines, packed->lines, sizeof(int) * packed->code_count);
+    chunk->capacity = chunk->count = packed->code_count;
+
+    for (int i = 0; i < packed->constant_count; i++) {
+        push(unpack_message(&packed->constants[i]));
+        write_value_array(&chunk->constants, vm->stack_top[-1]);
+        pop();
+    }
+    pop();
+    return function;
+}
+
+value_t unpack_message(message_t* message) {
+    switch (message->kind) {
+        case MESSAGE_VALUE:
+            return message->value;
+        case MESSAGE_STRING:
+            return OBJECT_VAL(copy_data_string(message->as.chars, message->count));
+        case MESSAGE_LIST: {
+            object_list_t* list = new_list(message->count, NIL_VAL);
+            push(OBJECT_VAL(list));
+            for (int i = 0; i < message->count; i++)
+                set_list_value(list, i, unpack_message(&message->as.items[i]));
+            return pop();
+        }
+        case MESSAGE_ARRAY: {
+            object_array_t* array = new_array(message->as.array.type, message->count);
+            memcpy(array->data, message->as.array.data, array_data_size(array->type, array->count));
+            return OBJECT_VAL(array);
+        }
+        case MESSAGE_CHANNEL:
+            return OBJECT_VAL(new_channel(message->as.channel));
+        case MESSAGE_FUNCTION:
+            return OBJECT_VAL(unpack_function(message->as.function));
+        case MESSAGE_CLOSURE: {
+            push(OBJECT_VAL(unpack_function(message->as.function)));
+            object_closure_t* closure = new_closure(AS_FUNCTION(vm->stack_top[-1]));
+            pop();
+            return OBJECT_VAL(closure);
+        }
+    }
+    return NIL_VAL;
+}
+
+void free_message(message_t* message) {
+    switch (message->kind) {
+        case MESSAGE_VALUE:
+            break;
+        case MESSAGE_STRING:
+            free(message->as.chars);
+            break;
+        case MESSAGE_LIST:
+            for (int i = 0; i < message->count; i++)
+                free_message(&message->as.items[i]);
+            free(message->as.items);
+            break;
+        case MESSAGE_ARRAY:
+            free(message->as.array.data);
+            break;
+        case MESSAGE_CHANNEL:
+            release_channel(message->as.channel);
+            break;
+        case MESSAGE_FUNCTION:
+        case MESSAGE_CLOSURE:
+            free_function(message->as.function);
+            break;
+    }
+    message->kind = MESSAGE_VALUE;
+}
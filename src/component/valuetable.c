@@ -6,6 +6,11 @@
 
 
 bool table_set_value(table_t* table, object_string_t* key, value_t value) {
+    void* old = NULL;
+    if (table_get(table, key, &old)) {
+        memcpy(old, &value, sizeof(value_t));
+        return false;
+    }
     value_t* v = ALLOCATE(value_t, 1);
     memcpy(v, &value, sizeof(value_t));
     return table_set(table, key, (void*) v);
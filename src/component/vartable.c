@@ -3,6 +3,11 @@
 #include "component/vartable.h"
 
 bool table_set_var(table_t* table, object_string_t* key, var_t var) {
+    void* old = NULL;
+    if (table_get(table, key, &old)) {
+        memcpy(old, &var, sizeof(var_t));
+        return false;
+    }
     var_t* v = ALLOCATE(var_t, 1);
     memcpy(v, &var, sizeof(var_t));
     return table_set(table, key, (void*) v);
@@ -16,6 +21,11 @@ bool table_get_var(table_t* table, object_string_t* key, var_t* var) {
     return result;
 }
 
+var_t* table_find_var(table_t* table, object_string_t* key) {
+    void* v = NULL;
+    return table_get(table, key, &v) ? (var_t*) v : NULL;
+}
+
 __attribute__((unused)) bool table_delete_var(table_t* table, object_string_t* key) {
     void* v = NULL;
     bool result = table_delete(table, key, &v);
@@ -26,7 +36,7 @@ __attribute__((unused)) bool table_delete_var(table_t* table, object_string_t* k
 }
 
 void free_table_var(table_t* table) {
-    for (int i = 0; i < table->count; ++i) {
+    for (int i = 0; i < table->capacity; ++i) {
         table_entry_t* entry = &table->entries[i];
         if (entry->key != NULL) {
             FREE(var_t, (var_t*) entry->value);
@@ -51,7 +51,7 @@ static int invoke_instruction(const char* name, chunk_t* chunk, int offset) {
     printf("%-20s %4d '", name, constant);
     print_value(chunk->constants.values[constant]);
     printf("' (%d args)\n", arg_count);
-    return offset + 3;
+    return offset + 4;
 }
 
 static int invoke_instruction_long(const char* name, chunk_t* chunk, int offset) {
@@ -62,7 +62,7 @@ static int invoke_instruction_long(const char* name, chunk_t* chunk, int offset)
     printf("%-20s %4d '", name, constant);
     print_value(chunk->constants.values[constant]);
     printf("' (%d args)\n", arg_count);
-    return offset + 4;
+    return offset + 5;
 }
 
 void disassemble_chunk(chunk_t* chunk, const char* name) {
@@ -137,15 +137,11 @@ int disassemble_instruction(chunk_t* chunk, int offset) {
         case OP_DEFINE_GLOBAL_LONG:
             return constant_instruction_long("OP_DEFINE_GLOBAL_LONG", chunk, offset);
         case OP_DEFINE_MUT_GLOBAL_LONG:
-            return constant_instruction("OP_DEFINE_MUT_GLOBAL_LONG", chunk, offset);
+            return constant_instruction_long("OP_DEFINE_MUT_GLOBAL_LONG", chunk, offset);
         case OP_GET_GLOBAL_LONG:
             return constant_instruction_long("OP_GET_GLOBAL_LONG", chunk, offset);
         case OP_SET_GLOBAL_LONG:
             return constant_instruction_long("OP_SET_GLOBAL_LONG", chunk, offset);
-        case OP_DEFINE_LOCAL:
-            return simple_instruction("OP_DEFINE_LOCAL", offset);
-        case OP_DEFINE_MUT_LOCAL:
-            return simple_instruction("OP_DEFINE_MUT_LOCAL", offset);
         case OP_GET_LOCAL:
             return byte_instruction("OP_GET_LOCAL", chunk, offset);
         case OP_SET_LOCAL:
@@ -158,12 +154,30 @@ int disassemble_instruction(chunk_t* chunk, int offset) {
             return constant_instruction("OP_METHOD", chunk, offset);
         case OP_METHOD_LONG:
             return constant_instruction_long("OP_METHOD_LONG", chunk, offset);
+        case OP_IMPORT:
+            return constant_instruction("OP_IMPORT", chunk, offset);
+        case OP_IMPORT_LONG:
+            return constant_instruction_long("OP_IMPORT_LONG", chunk, offset);
+        case OP_IMPORT_BIND:
+            return simple_instruction("OP_IMPORT_BIND", offset);
+        case OP_YIELD:
+            return simple_instruction("OP_YIELD", offset);
+        case OP_RESUME:
+            return simple_instruction("OP_RESUME", offset);
         case OP_INVOKE:
             return invoke_instruction("OP_INVOKE", chunk, offset);
         case OP_INVOKE_LONG:
             return invoke_instruction_long("OP_INVOKE_LONG", chunk, offset);
+        case OP_TAIL_INVOKE:
+            return invoke_instruction("OP_TAIL_INVOKE", chunk, offset);
+        case OP_TAIL_INVOKE_LONG:
+            return invoke_instruction_long("OP_TAIL_INVOKE_LONG", chunk, offset);
         case OP_ARRAY:
             return simple_instruction("OP_ARRAY", offset);
+        case OP_ARRAY_LITERAL:
+            return byte_instruction("OP_ARRAY_LITERAL", chunk, offset);
+        case OP_MAP_LITERAL:
+            return byte_instruction("OP_MAP_LITERAL", chunk, offset);
         case OP_GET_PROPERTY:
             return constant_instruction("OP_GET_PROPERTY", chunk, offset);
         case OP_GET_PROPERTY_LONG:
@@ -198,6 +212,24 @@ int disassemble_instruction(chunk_t* chunk, int offset) {
             return jump_instruction("OP_LOOP", -1, chunk, offset);
         case OP_CALL:
             return byte_instruction("OP_CALL", chunk, offset);
+        case OP_TAIL_CALL:
+            return byte_instruction("OP_TAIL_CALL", chunk, offset);
+        case OP_SQRT:
+            return simple_instruction("OP_SQRT", offset);
+        case OP_FLOOR:
+            return simple_instruction("OP_FLOOR", offset);
+        case OP_ABS:
+            return simple_instruction("OP_ABS", offset);
+        case OP_MIN:
+            return simple_instruction("OP_MIN", offset);
+        case OP_MAX:
+            return simple_instruction("OP_MAX", offset);
+        case OP_POW:
+            return simple_instruction("OP_POW", offset);
+        case OP_LEN:
+            return simple_instruction("OP_LEN", offset);
+        case OP_TYPE:
+            return simple_instruction("OP_TYPE", offset);
         case OP_CLOSURE_UPVALUE:
             return simple_instruction("OP_CLOSURE_UPVALUE", offset);
         case OP_INHERIT:
@@ -8,6 +8,10 @@
 
 #include "vm/vm.h"
 #include "vm/scanner.h"
+#include "utils/threadpool.h"
+#include "value/native/isolate.h"
+
+static vm_t* interpreter;
 
 static void repl() {
     char line[1024];
@@ -20,7 +24,7 @@ static void repl() {
         if (!strncmp(line, "exit", 4)) {
             break;
         }
-        interpret(line);
+        interpret(interpreter, line);
     }
 }
 
@@ -62,7 +66,7 @@ static char* read_file(const char* path) {
 
 static void run_file(const char* path) {
     char* source = read_file(path);
-    interpret_result_t result = interpret(source);
+    interpret_result_t result = interpret_file(interpreter, path, source);
     free(source);
 
     if (result == INTERPRET_COMPILE_ERROR) exit(65);
@@ -71,13 +75,15 @@ static void run_file(const char* path) {
 
 void launch_interpreter() {
     launch_scanner();
-    init_vm();
+    interpreter = new_vm();
 
 }
 
 void shutdown_interpreter() {
-    free_vm();
+    shutdown_isolates();
+    free_vm(interpreter);
     free_scanner();
+    shutdown_thread_pool();
 }
 
 int main(int argc, const char **argv) {
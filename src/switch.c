@@ -1,6 +0,0 @@
-//
-// Created by shenshuhan on 12/27/23.
-//
-#include "switch.h"
-
-bool do_garbage_collector;
\ No newline at end of file
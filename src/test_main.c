@@ -1,30 +1,757 @@
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "common.h"
 
-#include "component/keywordtrie.h"
+#include "component/keyword.h"
 #include "utils/trie.h"
+#include "utils/simd.h"
+#include "utils/threadpool.h"
+#include "utils/output.h"
+#include "component/vartable.h"
+#include "vm/runtime.h"
+#include "vm/compiler.h"
+#include "value/object/channel.h"
+#include "value/object/class.h"
+#include "value/object/map.h"
+#include "value/object/rope.h"
 
+/*
+ * Runs 'source' in a VM of its own and keeps that VM running, so global() reads what the script left behind.
+ * Returns the VM that ran before, end_script() switches back to it and frees the script's VM.
+ */
+static vm_t* run_script(const char* source) {
+    vm_t* machine = new_vm();
+    assert(interpret(machine, source) == INTERPRET_OK);
+    return switch_vm(machine);
+}
 
-int main(int argc, const char** argv) {
+static void end_script(vm_t* enclosing) {
+    free_vm(switch_vm(enclosing));
+}
 
-    trie_t trie;
-    trie_debug(&trie);
+// the global 'name' of the running VM's script, which has to exist
+static value_t global(const char* name) {
+    var_t var;
+    assert(table_get_var(&vm->main->globals, copy_string(name, (int)strlen(name)), &var));
+    return var.v;
+}
+
+static value_t element(value_t list, int index) {
+    value_t value;
+    assert(get_list_value(AS_LIST(list), index, &value) == 0);
+    return value;
+}
+
+static void test_simd() {
+    int64_t ints[37];
+    double floats[37];
+    uint8_t bytes[300];
+    for (int i = 0; i < 37; i++) {
+        ints[i] = i - 18;
+        floats[i] = i * 0.5;
+    }
+    for (int i = 0; i < 300; i++)
+        bytes[i] = (uint8_t)(i * 7);
+
+    assert(simd_sum_i64(ints, 37) == 0);
+    assert(simd_sum_f64(floats, 37) == 333.0);
+    uint64_t byte_sum = 0;
+    for (int i = 0; i < 300; i++) byte_sum += bytes[i];
+    assert(simd_sum_u8(bytes, 300) == byte_sum);
+
+    int64_t lo, hi;
+    simd_min_max_i64(ints, 37, &lo, &hi);
+    assert(lo == -18 && hi == 18);
+    uint8_t blo, bhi;
+    simd_min_max_u8(bytes, 300, &blo, &bhi);
+    assert(blo == 0 && bhi == 255);
+
+    assert(simd_dot_i64(ints, ints, 37) == 4218);
+
+    int64_t out[37];
+    simd_scalar_i64(SIMD_MUL, out, ints, 3, 37);
+    simd_binary_i64(SIMD_SUB, out, out, ints, 37);
+    for (int i = 0; i < 37; i++)
+        assert(out[i] == 2 * ints[i]);
+
+    uint64_t words[5] = {~0ULL, 0, 1, 3, 7};
+    assert(simd_popcount(words, 5) == 70);
+}
+
+/*
+ * Integer array division rejects a zero divisor and INT64_MIN / -1 before any element is written.
+ */
+static void test_array_division() {
+    vm_t* enclosing = run_script("var a = int_array(4); array_fill(a, (-9223372036854775807) - 1); var b = int_array(4); array_fill(b, -1);");
+    assert(interpret(vm, "array_div(a, a, 0);") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(vm, "array_div(a, a, int_array(4));") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(vm, "array_div(a, a, -1);") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(vm, "array_div(a, a, b);") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(vm, "var first = array_min(a); array_div(a, a, 2); var halved = array_max(a);") == INTERPRET_OK);
+
+    assert(AS_INT(global("first")) == INT64_MIN && AS_INT(global("halved")) == INT64_MIN / 2);
+    end_script(enclosing);
+}
+
+static void test_keywords() {
+    static const struct { const char* name; tokentype_t type; } keywords[] = {
+        {"and", TOKEN_AND}, {"class", TOKEN_CLASS}, {"this", TOKEN_THIS}, {"else", TOKEN_ELSE},
+        {"if", TOKEN_IF}, {"or", TOKEN_OR}, {"super", TOKEN_SUPER}, {"mut", TOKEN_MUT},
+        {"var", TOKEN_VAR}, {"fun", TOKEN_FUN}, {"lambda", TOKEN_LAMBDA}, {"print", TOKEN_PRINT},
+        {"println", TOKEN_PRINTLN}, {"while", TOKEN_WHILE}, {"for", TOKEN_FOR}, {"return", TOKEN_RETURN},
+        {"break", TOKEN_BREAK}, {"continue", TOKEN_CONTINUE}, {"nil", TOKEN_NIL}, {"true", TOKEN_TRUE},
+        {"false", TOKEN_FALSE}, {"import", TOKEN_IMPORT}, {"yield", TOKEN_YIELD}, {"resume", TOKEN_RESUME},
+    };
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
+        assert(keyword_type(keywords[i].name, (int)strlen(keywords[i].name)) == keywords[i].type);
+
+    static const char* identifiers[] = {"ans", "an", "andd", "prints", "printl", "Class", "_if", "x1", "f", "fe", "tre"};
+    for (size_t i = 0; i < sizeof(identifiers) / sizeof(identifiers[0]); i++)
+        assert(keyword_type(identifiers[i], (int)strlen(identifiers[i])) == TOKEN_IDENTIFIER);
+    // only a prefix of the buffer is the token
+    assert(keyword_type("forward", 3) == TOKEN_FOR);
+}
+
+/*
+ * Doubling a rope is cheap, '+' stops with an error once the result would pass STRING_LENGTH_MAX.
+ */
+static void test_rope_length() {
+    vm_t* machine = new_vm();
+    assert(interpret(machine, "var mut s = \"x\"; while (true) s = s + s;") == INTERPRET_RUNTIME_ERROR);
+
+    vm_t* enclosing = switch_vm(machine);
+    assert(string_like_length(global("s")) == STRING_LENGTH_MAX);
+    end_script(enclosing);
+}
+
+#define CONCURRENT_VMS 4
+
+typedef struct {
+    int seed;
+    int64_t result;
+} vm_job_t;
+
+static void* run_vm(void* arg) {
+    vm_job_t* job = arg;
+    char source[256];
+    snprintf(source, sizeof source,
+             "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+             "var mut total = %d;\n"
+             "for (var mut i = 0; i < 5; i = i + 1) total = total + fib(15);\n"
+             "var result = total;\n", job->seed);
+
+    vm_t* enclosing = run_script(source);
+    job->result = AS_INT(global("result"));
+    end_script(enclosing);
+    return NULL;
+}
+
+/*
+ * Every thread runs a VM of its own, the globals of one never show up in another.
+ */
+static void test_concurrent_vms() {
+    pthread_t threads[CONCURRENT_VMS];
+    vm_job_t jobs[CONCURRENT_VMS];
+    for (int i = 0; i < CONCURRENT_VMS; i++) {
+        jobs[i].seed = i * 1000;
+        assert(!pthread_create(&threads[i], NULL, run_vm, &jobs[i]));
+    }
+    for (int i = 0; i < CONCURRENT_VMS; i++) {
+        pthread_join(threads[i], NULL);
+        assert(jobs[i].result == i * 1000 + 5 * 610);
+    }
+}
+
+/*
+ * A generator suspended and resumed many times over, with a garbage collection on every allocation.
+ */
+static void test_fibers() {
+    const char* source =
+        "fun squares(n) { for (var mut i = 0; i < n; i = i + 1) yield i * i; return -1; }\n"
+        "var gen = fiber(squares);\n"
+        "var mut total = 0;\n"
+        "var mut value = resume(gen, 100);\n"
+        "while (!fiber_done(gen)) { total = total + value; value = resume(gen); }\n"
+        "var result = [total, value];\n";
+
+    vm_t* enclosing = run_script(source);
+    value_t result = global("result");
+    assert(AS_INT(element(result, 0)) == 328350 && AS_INT(element(result, 1)) == -1);
+    // the generator's call stack is gone once it finished, the running one is the root again
+    assert(vm->fiber == NULL && vm->stack == vm->root.stack);
+    end_script(enclosing);
+}
+
+/*
+ * Two tasks bouncing a counter over a pair of pipes, each read parks a task until the other one writes.
+ */
+static void test_event_loop() {
+    const char* source =
+        "var there = pipe();\n"
+        "var back = pipe();\n"
+        "var mut rounds = 0;\n"
+        "fun ping(n) { for (var mut i = 0; i < n; i = i + 1) { write(there[1], \"x\"); read(back[0], 1); rounds = rounds + 1; } }\n"
+        "fun pong(n) { for (var mut i = 0; i < n; i = i + 1) { read(there[0], 1); write(back[1], \"y\"); } }\n"
+        "var mut order = [];\n"
+        "fun wake(ms) { sleep(ms); append(order, ms); }\n"
+        "task(pong, 200);\n"
+        "task(ping, 200);\n"
+        "task(wake, 6);\n"
+        "task(wake, 2);\n"
+        "task(wake, 4);\n";
+
+    vm_t* enclosing = run_script(source);
+    assert(AS_INT(global("rounds")) == 200);
+    for (int i = 0; i < 3; i++)
+        assert(AS_INT(element(global("order"), i)) == (i + 1) * 2);
+    // interpret() only returns once every task is done
+    assert(vm->loop.ready_count == 0 && vm->loop.timer_count == 0 && vm->loop.waiting == 0);
+    assert(vm->fiber == NULL && vm->stack == vm->root.stack);
+    end_script(enclosing);
+}
+
+/*
+ * Tail calls reuse the caller's frame, recursing far deeper than FRAMES_MAX works.
+ */
+static void test_tail_calls() {
+    char source[512];
+    snprintf(source, sizeof source,
+             "fun count(n, acc) { if (n == 0) return acc; return count(n - 1, acc + 1); }\n"
+             "fun even(n) { if (n == 0) return true; return odd(n - 1); }\n"
+             "fun odd(n) { if (n == 0) return false; return even(n - 1); }\n"
+             "class C { init() { this.step = count; } loop(n) { if (n == 0) return \"done\"; return this.loop(n - 1); } run(n) { return this.step(n, 0); } }\n"
+             "var result = [count(%d, 0), even(%d), C().loop(%d), C().run(%d)];\n",
+             FRAMES_MAX * 2, FRAMES_MAX * 2 + 1, FRAMES_MAX * 2, FRAMES_MAX * 2);
+
+    vm_t* enclosing = run_script(source);
+    value_t result = global("result");
+    assert(AS_INT(element(result, 0)) == FRAMES_MAX * 2 && !AS_BOOL(element(result, 1)));
+    // 'return this.loop(...)' and a function held in a field reuse the frame like plain calls
+    assert(values_equal(element(result, 2), OBJECT_VAL(copy_string("done", 4))));
+    assert(AS_INT(element(result, 3)) == FRAMES_MAX * 2);
+    end_script(enclosing);
+}
+
+/*
+ * Deep recursion grows the call stack many times over, open upvalues follow it when it moves.
+ */
+static void test_stack_growth() {
+    const char* source =
+        "fun depth(n) { if (n == 0) return 0; return 1 + depth(n - 1); }\n"
+        "fun nest(n) { var mut x = n; fun get() { return x; } if (n == 0) return get; var inner = nest(n - 1); x = x + inner(); return get; }\n"
+        "var result = [depth(20000), nest(2000)()];\n";
+
+    vm_t* enclosing = run_script(source);
+    value_t result = global("result");
+    assert(AS_INT(element(result, 0)) == 20000 && AS_INT(element(result, 1)) == 2000 * 2001 / 2);
+    assert(vm->root.frame_capacity > FRAMES_INITIAL && vm->root.stack_capacity > STACK_INITIAL);
+    end_script(enclosing);
+}
+
+#define DEEP_EXPRESSION 1100
+#define LITERAL_LEVELS  5
+
+// '[1, 1, ..., [1, 1, ..., [...]]]', every level holds 250 elements
+static char* append_nested_literal(char* out, int levels) {
+    *out++ = '[';
+    for (int i = 0; i < 249; i++)
+        out += sprintf(out, "1, ");
+    if (levels > 1)
+        out = append_nested_literal(out, levels - 1);
+    else
+        *out++ = '1';
+    *out++ = ']';
+    return out;
+}
+
+/*
+ * Temporaries are not bounded by a fixed number per frame, calls reserve what the compiler counted.
+ */
+static void test_stack_depth() {
+    char* source = malloc(DEEP_EXPRESSION * 8 + LITERAL_LEVELS * 250 * 3 * 2 + 256);
+    char* out = source + sprintf(source, "var deep = ");
+    for (int i = 0; i < DEEP_EXPRESSION; i++)
+        out += sprintf(out, "1 + (");
+    *out++ = '1';
+    memset(out, ')', DEEP_EXPRESSION);
+    out += DEEP_EXPRESSION;
+    out += sprintf(out, ";\nvar top = ");
+    out = append_nested_literal(out, LITERAL_LEVELS);
+    out += sprintf(out, ";\nfun nested() { return ");
+    out = append_nested_literal(out, LITERAL_LEVELS);
+    sprintf(out, "; }\nvar inner = nested();\n");
+
+    vm_t* enclosing = run_script(source);
+    free(source);
+    assert(AS_INT(global("deep")) == DEEP_EXPRESSION + 1);
+    assert(AS_LIST(global("top"))->count == 250 && AS_LIST(global("inner"))->count == 250);
+
+    object_function_t* function = compile("fun f(a, b) { return a + b * 2; }", vm->main);
+    object_function_t* f = AS_CLOSURE(function->chunk.constants.values[1])->function;
+    assert(function->max_slots == 2 && f->max_slots == 6);
+    end_script(enclosing);
+}
+
+/*
+ * Assigning an immutable local or captured variable is a compile error, mutable ones are plain stores.
+ */
+static void test_mutability() {
+    const char* source =
+        "fun f(mut a, b) { a = a + b; return a; }\n"
+        "fun counter() { var mut n = 0; fun next() { n = n + 1; return n; } return next; }\n"
+        "var next = counter();\n"
+        "next();\n"
+        "var result = [f(1, 2), next()];\n";
+    static const char* rejected[] = {
+        "fun f(a) { a = 1; }",
+        "fun f(mut a, b) { b = 1; }",
+        "{ var x = 1; x = 2; }",
+        "{ var x = 1; fun f() { fun g() { x = 2; } } }",
+    };
+
+    vm_t* enclosing = run_script(source);
+    for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++)
+        assert(interpret(vm, rejected[i]) == INTERPRET_COMPILE_ERROR);
+    value_t result = global("result");
+    assert(AS_INT(element(result, 0)) == 3 && AS_INT(element(result, 1)) == 2);
+    end_script(enclosing);
+}
+
+static void test_method_slots() {
+    // one invoke site sees every receiver, its slot hint must never pick the wrong method
+    const char* source =
+        "class A { id() { return 1; } kind() { return this.id() * 10; } }\n"
+        "class B < A { id() { return 2; } }\n"
+        "class C < B { extra() { return 0; } }\n"
+        "class D { pad() { return 0; } id() { return 4; } }\n"
+        "fun f() { return 5; }\n"
+        "var shadowed = A();\n"
+        "shadowed.id = f;\n"
+        "var receivers = [A(), B(), C(), D(), shadowed, A()];\n"
+        "var result = [];\n"
+        "for (var mut i = 0; i < 6; i = i + 1) append(result, receivers[i].id());\n"
+        "append(result, C().kind());\n";
+    static const int expected[] = {1, 2, 2, 4, 5, 1, 20};
+
+    vm_t* enclosing = run_script(source);
+    for (int i = 0; i < 7; i++)
+        assert(AS_INT(element(global("result"), i)) == expected[i]);
+
+    // inherited and overridden methods keep the slot they have in the superclass
+    object_class_t* a = AS_CLASS(global("A"));
+    object_class_t* c = AS_CLASS(global("C"));
+    object_string_t* id = copy_string("id", 2);
+    assert(class_find_method(a, id) == class_find_method(c, id));
+    assert(c->method_count == 3);
+    end_script(enclosing);
+}
 
-    keyword_trie_t test;
-    keyword_trie_init(&test);
+static void test_instantiation() {
+    const char* source =
+        "class A { init(x) { this.x = x; this.a = 1; this.b = 2; this.c = 3; this.d = 4; this.e = 5; this.f = 6; } }\n"
+        "class B < A {}\n"
+        "class C < A { init(x) { super.init(x * 10); } }\n"
+        "var a = A(1);\n"
+        "var result = [a.x, B(2).x, C(3).x];\n";
+    static const int expected[] = {1, 2, 30};
 
-    keyword_trie_insert(&test, "and", TOKEN_AND);
+    vm_t* enclosing = run_script(source);
+    for (int i = 0; i < 3; i++)
+        assert(AS_INT(element(global("result"), i)) == expected[i]);
 
-    keyword_trie_node_t* x;
-    trie_find_node(keyword_trie_node_t, trie_node, &test.trie, "and", &x);
-    assert(x != NULL);
-    assert(TOKEN_AND == x->tokentype);
+    // 'init' is cached and inherited, later instances reserve room for every field 'init' sets
+    object_class_t* klass = AS_CLASS(global("A"));
+    assert(klass->initializer != NULL && klass->initializer == AS_CLASS(global("B"))->initializer);
+    assert(klass->field_count == 7);
+    object_instance_t* instance = new_instance(klass);
+    assert(instance->fields.count == 0 && instance->fields.capacity * TABLE_MAX_LOAD >= 7);
+    end_script(enclosing);
+}
 
-    trie_find_node(keyword_trie_node_t, trie_node, &test.trie, "ans", &x);
-    assert(x == NULL);
+static void test_intrinsics() {
+    const char* source =
+        "var result = [sqrt(16), floor(-2.5), abs(-3), min(1, 2.5), max(1, 2.5), pow(3, 4), len(\"ab\" + \"c\")];\n"
+        "fun first() { return len([1]); }\n"
+        "var before = first();\n"
+        "fun len(x) { return -1; }\n"
+        "var after = first();\n";
+    vm_t* enclosing = run_script(source);
+    assert(interpret(vm, "var later = len([1]);") == INTERPRET_OK);
+    assert(interpret(vm, "pow(1);") == INTERPRET_COMPILE_ERROR);
+    assert(interpret(vm, "abs(\"a\");") == INTERPRET_RUNTIME_ERROR);
+    // a function compiled before the module defines the name calls the global from then on
+    assert(interpret(vm, "fun bigger(a, b) { return max(a, b) + 1; }\nvar small = bigger(1, 2);") == INTERPRET_OK);
+    assert(interpret(vm, "fun max(a, b) { return a * b; }\nvar big = bigger(3, 4);") == INTERPRET_OK);
+
+    value_t result = global("result");
+    assert(IS_FLOAT(element(result, 0)) && AS_FLOAT(element(result, 0)) == 4.0);
+    assert(IS_INT(element(result, 1)) && AS_INT(element(result, 1)) == -3);
+    assert(IS_INT(element(result, 2)) && AS_INT(element(result, 2)) == 3);
+    assert(IS_INT(element(result, 3)) && AS_INT(element(result, 3)) == 1);
+    assert(IS_FLOAT(element(result, 4)) && AS_FLOAT(element(result, 4)) == 2.5);
+    assert(IS_INT(element(result, 5)) && AS_INT(element(result, 5)) == 81);
+    assert(IS_INT(element(result, 6)) && AS_INT(element(result, 6)) == 3);
+
+    // a global declared anywhere in the source, or by an earlier one, keeps calls ordinary
+    assert(AS_INT(global("before")) == 1 && AS_INT(global("after")) == -1 && AS_INT(global("later")) == -1);
+    assert(AS_INT(global("small")) == 3 && AS_INT(global("big")) == 13);
+
+    object_function_t* function = compile("sqrt(4);", vm->main);
+    assert(function != NULL && function->chunk.code[2] == OP_SQRT);
+    end_script(enclosing);
+}
+
+static void test_bench() {
+    const char* source =
+        "var mut calls = 0;\n"
+        "fun work() { calls = calls + 1; return [calls]; }\n"
+        "var r = bench(work, 20);\n"
+        "var result = [r.iterations, calls, r.min <= r.median and r.median <= r.p99, r.allocations, clock_ns() > 0];\n";
+    vm_t* enclosing = run_script(source);
+    // an error inside the benchmarked function unwinds everything, the VM stays usable
+    assert(interpret(vm, "fun bad() { return nil + 1; } bench(bad, 5);") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(vm, "var after = bench(work, 1).iterations;") == INTERPRET_OK);
+
+    value_t result = global("result");
+    // 20 measured calls after 20 / 10 + 1 warmup calls, each allocating one list
+    assert(AS_INT(element(result, 0)) == 20 && AS_INT(element(result, 1)) == 23);
+    assert(AS_BOOL(element(result, 2)));
+    assert(AS_FLOAT(element(result, 3)) == 1.0);
+    assert(AS_BOOL(element(result, 4)));
+    assert(AS_INT(global("after")) == 1 && vm->frame_base == 0);
+    end_script(enclosing);
+}
+
+static void test_output() {
+    FILE* file = tmpfile();
+    assert(file != NULL);
+    char buffer[8];
+    output_t out;
+    init_output(&out, file, buffer, sizeof(buffer), false);
+
+    // nothing reaches the file until the buffer is full or flushed
+    assert(output_write(&out, "abcde", 5) == 5);
+    fflush(file);
+    assert(ftell(file) == 0);
+    assert(output_write(&out, "fghij", 5) == 5);
+    fflush(file);
+    assert(ftell(file) == 5 && out.count == 5);
+
+    // longer than the buffer and formatted numbers
+    const char* expected =
+        "abcdefghij|0123456789abcdef|-9223372036854775808|9223372036854775807|0|-42|"
+        "0.1|0.30000000000000004|2.5|1e+20|-0|1e-05|123|0.3333333333333333|1.7976931348623157e+308|"
+        "nan|inf|-inf|x=7";
+    output_string(&out, "|0123456789abcdef|");
+    output_int(&out, INT64_MIN);
+    output_string(&out, "|");
+    output_int(&out, INT64_MAX);
+    output_string(&out, "|");
+    output_int(&out, 0);
+    output_string(&out, "|");
+    output_int(&out, -42);
+    const double floats[] = {0.1, 0.1 + 0.2, 2.5, 1e20, -0.0, 1e-5, 123.0, 1.0 / 3.0, 1.7976931348623157e308,
+                             NAN, INFINITY, -INFINITY};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        output_string(&out, "|");
+        output_float(&out, floats[i]);
+    }
+    output_string(&out, "|");
+    output_format(&out, "x=%d", 7);
+    flush_output(&out);
+    assert(out.count == 0);
+
+    char written[256] = {0};
+    rewind(file);
+    assert(fread(written, 1, sizeof(written) - 1, file) == strlen(expected));
+    assert(strcmp(written, expected) == 0);
+    fclose(file);
+
+    // line buffered output is handed over at every newline
+    file = tmpfile();
+    init_output(&out, file, buffer, sizeof(buffer), true);
+    output_write(&out, "ab\nc", 4);
+    fflush(file);
+    assert(ftell(file) == 4 && out.count == 0);
+    fclose(file);
+}
+
+static void test_files() {
+    char path[] = "/tmp/clox_test_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    // the last line has no newline, the one before it is empty
+    const char* content = "first\nsecond\n\nlast";
+    assert(write(fd, content, strlen(content)) == (ssize_t)strlen(content));
+    close(fd);
+
+    char source[512];
+    snprintf(source, sizeof(source),
+        "var text = read_file(\"%s\");\n"
+        "var r = lines(\"%s\");\n"
+        "var result = [];\n"
+        "var mut line = read_line(r);\n"
+        "while (line != nil) { append(result, line); line = read_line(r); }\n"
+        "var missing = [read_file(\"%s.missing\"), lines(\"%s.missing\"), read_line(r)];\n",
+        path, path, path, path);
+    vm_t* enclosing = run_script(source);
+    assert(interpret(vm, "read_line(\"not a reader\");") == INTERPRET_RUNTIME_ERROR);
+
+    object_string_t* text = AS_STRING(global("text"));
+    assert(text->mapped && text->length == (int)strlen(content));
+    assert(text->chars[text->length] == 0);
+    assert(memcmp(text->chars, content, strlen(content)) == 0);
+
+    value_t result = global("result");
+    const char* expected[] = {"first", "second", "", "last"};
+    assert(AS_LIST(result)->count == 4);
+    for (int i = 0; i < 4; i++) {
+        value_t line = element(result, i);
+        // lines read by I/O are not interned, they still equal the interned string with the same chars
+        assert(!AS_STRING(line)->interned);
+        assert(values_equal(line, OBJECT_VAL(copy_string(expected[i], (int)strlen(expected[i])))));
+    }
+    for (int i = 0; i < 3; i++)
+        assert(IS_NIL(element(global("missing"), i)));
+    end_script(enclosing);
+    unlink(path);
+}
+
+static void write_file(const char* path, const char* content) {
+    FILE* file = fopen(path, "w");
+    assert(file != NULL);
+    fputs(content, file);
+    fclose(file);
+}
+
+/*
+ * An import binds a snapshot of the globals the module defines itself and never replaces a global of the importer.
+ */
+static void test_import_bindings() {
+    char directory[] = "/tmp/clox_modules_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    char inner[64], module[64];
+    snprintf(inner, sizeof(inner), "%s/inner.lox", directory);
+    snprintf(module, sizeof(module), "%s/m.lox", directory);
+    write_file(inner, "var helper = 7;\n");
+    write_file(module,
+        "import \"inner.lox\";\n"
+        "var mut counter = 0;\n"
+        "fun bump() { counter = counter + 1; }\n"
+        "fun get() { return counter; }\n");
+
+    char source[256];
+    snprintf(source, sizeof(source), "var mut counter = 100;\nimport \"%s\";", module);
+    vm_t* machine = new_vm();
+    assert(interpret(machine, source) == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(machine, "counter = counter + 1;") == INTERPRET_OK);
+
+    vm_t* enclosing = switch_vm(machine);
+    var_t counter;
+    assert(table_get_var(&vm->main->globals, copy_string("counter", 7), &counter));
+    assert(counter.mutable && AS_INT(counter.v) == 101);
+    assert(!table_get_var(&vm->main->globals, copy_string("bump", 4), &counter));
+    end_script(enclosing);
+
+    snprintf(source, sizeof(source), "import \"%s\";\nimport \"%s\";\nbump(); bump();\nvar now = get();", module, module);
+    enclosing = run_script(source);
+    assert(interpret(vm, "counter = 5;") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(vm, "helper;") == INTERPRET_RUNTIME_ERROR);
+    assert(table_get_var(&vm->main->globals, copy_string("counter", 7), &counter));
+    assert(!counter.mutable && AS_INT(counter.v) == 0 && AS_INT(global("now")) == 2);
+    end_script(enclosing);
+    unlink(inner);
+    unlink(module);
+    rmdir(directory);
+}
+
+static void test_map() {
+    vm_t* machine = new_vm();
+    vm_t* enclosing = switch_vm(machine);
+    object_map_t* map = new_map(0);
+    value_t key, value;
+
+    // enough entries to grow several times, then half of them deleted and inserted again
+    for (int i = 0; i < 1000; i++) {
+        assert(map_key(INT_VAL(i), &key));
+        map_set(map, key, INT_VAL(i * i));
+    }
+    assert(map->count == 1000 && map->capacity % MAP_GROUP_WIDTH == 0);
+    for (int i = 0; i < 1000; i += 2)
+        assert(map_remove(map, INT_VAL(i)));
+    assert(!map_remove(map, INT_VAL(0)) && map->count == 500);
+    for (int i = 0; i < 1000; i++)
+        assert(map_get(map, INT_VAL(i), &value) == (i % 2 == 1) && (i % 2 == 0 || AS_INT(value) == i * i));
+    int capacity = map->capacity;
+    for (int r = 0; r < 10; r++) {
+        for (int i = 0; i < 1000; i += 2)
+            map_set(map, INT_VAL(i), INT_VAL(-i));
+        for (int i = 0; i < 1000; i += 2)
+            assert(map_remove(map, INT_VAL(i)));
+    }
+    // deleted slots are reused or cleared by rebuilding, churn does not grow the map
+    assert(map->capacity == capacity && map->count == 500);
+
+    // keys of different types are different keys, -0.0 is 0.0, NaN and objects are no keys
+    map_set(map, BOOL_VAL(true), INT_VAL(1));
+    map_set(map, FLOAT_VAL(1.0), INT_VAL(2));
+    assert(map_get(map, INT_VAL(1), &value) && AS_INT(value) == 1);
+    assert(map_get(map, FLOAT_VAL(1.0), &value) && AS_INT(value) == 2);
+    assert(map_get(map, BOOL_VAL(true), &value) && AS_INT(value) == 1);
+    assert(map_key(FLOAT_VAL(-0.0), &key));
+    map_set(map, key, INT_VAL(3));
+    assert(map_get(map, FLOAT_VAL(0.0), &value) && AS_INT(value) == 3);
+    assert(!map_key(FLOAT_VAL(NAN), &key));
+    assert(!map_key(NIL_VAL, &key));
+    assert(!map_key(OBJECT_VAL(map), &key));
+    assert(map_key(OBJECT_VAL(copy_string("key", 3)), &key));
+    map_set(map, key, INT_VAL(4));
+    assert(map_get(map, OBJECT_VAL(copy_string("key", 3)), &value) && AS_INT(value) == 4);
+    switch_vm(enclosing);
+
+    const char* source =
+        "var m = {\"a\": 1, 2: \"b\",};\n"
+        "m[\"c\"] = 3;\n"
+        "var result = [m[\"a\"], m[2], m[\"c\"], m[\"d\"], len(m), len(keys(m)), has(m, 2), remove(m, 2), has(m, 2)];\n";
+    assert(interpret(machine, source) == INTERPRET_OK);
+    assert(interpret(machine, "m[[]] = 1;") == INTERPRET_RUNTIME_ERROR);
+    assert(interpret(machine, "var bad = {nil: 1};") == INTERPRET_RUNTIME_ERROR);
+    enclosing = switch_vm(machine);
+    value_t result = global("result");
+    assert(AS_INT(element(result, 0)) == 1 && AS_STRING(element(result, 1)) == copy_string("b", 1));
+    assert(AS_INT(element(result, 2)) == 3 && IS_NIL(element(result, 3)));
+    assert(AS_INT(element(result, 4)) == 3 && AS_INT(element(result, 5)) == 3);
+    assert(AS_BOOL(element(result, 6)) && AS_BOOL(element(result, 7)) && !AS_BOOL(element(result, 8)));
+    end_script(enclosing);
+}
+
+static void test_uninterned_strings() {
+    // two equal strings longer than STRING_INTERN_MAX built apart, and a short one
+    const char* source =
+        "var mut a = \"\";\n"
+        "var mut b = \"\";\n"
+        "for (var mut i = 0; i < 40; i = i + 1) { a = a + \"0123456789\"; b = b + \"0123456789\"; }\n"
+        "var m = {};\n"
+        "m[a] = 1;\n"
+        "var result = [a == b, m[b], a == b + \"x\", \"ab\" + \"c\" == \"abc\"];\n";
+    vm_t* enclosing = run_script(source);
+    object_string_t* flat_a = AS_STRING(flatten_value(global("a")));
+    object_string_t* flat_b = AS_STRING(flatten_value(global("b")));
+    assert(flat_a != flat_b && flat_a->length == 400 && !flat_a->interned && !flat_b->interned);
+    // keying the map hashed 'a' and the lookup hashed 'b'
+    assert(flat_a->hashed && flat_b->hashed && flat_a->hash == flat_b->hash);
+    assert(strings_equal(flat_a, flat_b));
+
+    value_t result = global("result");
+    assert(AS_BOOL(element(result, 0)) && AS_INT(element(result, 1)) == 1);
+    assert(!AS_BOOL(element(result, 2)) && AS_BOOL(element(result, 3)));
+
+    // names are always interned, data only up to STRING_INTERN_MAX
+    char long_chars[STRING_INTERN_MAX + 1];
+    memset(long_chars, 'x', sizeof(long_chars));
+    assert(copy_string(long_chars, sizeof(long_chars))->interned);
+    assert(copy_data_string(long_chars, STRING_INTERN_MAX)->interned);
+    object_string_t* data = copy_data_string(long_chars, sizeof(long_chars));
+    assert(!data->interned && !data->hashed);
+    assert(strings_equal(data, copy_string(long_chars, sizeof(long_chars))));
+    end_script(enclosing);
+}
+
+#define PRODUCERS 4
+#define MESSAGES_PER_PRODUCER 10000
+
+typedef struct {
+    int id;
+    channel_t* channel;
+} producer_t;
+
+static void* produce(void* arg) {
+    producer_t* producer = arg;
+    for (int i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+        message_t message = {.kind = MESSAGE_VALUE, .value = INT_VAL(producer->id * MESSAGES_PER_PRODUCER + i)};
+        channel_send(producer->channel, message);
+    }
+    return NULL;
+}
+
+/*
+ * Several senders against one receiver: nothing is lost and every sender's messages arrive in order.
+ */
+static void test_channel() {
+    channel_t* channel = new_shared_channel();
+    pthread_t threads[PRODUCERS];
+    producer_t producers[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        producers[i] = (producer_t) {i, channel};
+        assert(!pthread_create(&threads[i], NULL, produce, &producers[i]));
+    }
+
+    int64_t next[PRODUCERS] = {0};
+    for (int i = 0; i < PRODUCERS * MESSAGES_PER_PRODUCER; i++) {
+        message_t message;
+        assert(channel_receive(channel, &message));
+        assert(message.kind == MESSAGE_VALUE);
+        int64_t value = AS_INT(message.value);
+        int id = (int)(value / MESSAGES_PER_PRODUCER);
+        assert(value % MESSAGES_PER_PRODUCER == next[id]);
+        next[id]++;
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        assert(next[i] == MESSAGES_PER_PRODUCER);
+    }
+    release_channel(channel);
+}
+
+static void square_chunk(void* context, int chunk) {
+    int64_t* squares = context;
+    squares[chunk] = (int64_t)chunk * chunk;
+}
+
+static void test_thread_pool() {
+    int64_t squares[100] = {0};
+    parallel_for(100, square_chunk, squares);
+    parallel_for(100, square_chunk, squares);
+    for (int i = 0; i < 100; i++)
+        assert(squares[i] == (int64_t)i * i);
+    shutdown_thread_pool();
+}
+
+
+int main(int argc, const char** argv) {
+
+    trie_t trie;
+    trie_debug(&trie);
 
-    keyword_trie_free(&test);
+    test_keywords();
+    test_rope_length();
+    test_simd();
+    test_array_division();
+    test_concurrent_vms();
+    test_channel();
+    test_fibers();
+    test_event_loop();
+    test_tail_calls();
+    test_stack_growth();
+    test_stack_depth();
+    test_mutability();
+    test_method_slots();
+    test_instantiation();
+    test_intrinsics();
+    test_bench();
+    test_output();
+    test_files();
+    test_import_bindings();
+    test_map();
+    test_uninterned_strings();
+    test_thread_pool();
 
     return 0;
 }
\ No newline at end of file
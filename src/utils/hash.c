@@ -0,0 +1,56 @@
+#include <string.h>
+
+#include "utils/hash.h"
+
+#define HASH_SEED_0 0xa0761d6478bd642full
+#define HASH_SEED_1 0xe7037ed1a0b428dbull
+#define HASH_SEED_2 0x8ebc6af09c88c6e3ull
+
+/*
+ * Multiply two words into 128 bits and fold the halves together,
+ * one multiplication mixes every input bit into every output bit.
+ */
+static inline uint64_t mix(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t r = a * b;
+    return r ^ (r >> 32) ^ ((a >> 32) * (b >> 32));
+#endif
+}
+
+static inline uint64_t read_word(const char* p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof word);
+    return word;
+}
+
+/*
+ * Short tails (most identifiers fit entirely in one) are read without a byte loop:
+ * 4..7 bytes as two overlapping 32 bit loads, 1..3 bytes as first, middle and last byte.
+ */
+static inline uint64_t read_tail(const char* p, int n) {
+    if (n >= 4) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, sizeof lo);
+        memcpy(&hi, p + n - 4, sizeof hi);
+        return ((uint64_t)hi << 32) | lo;
+    }
+    if (n > 0)
+        return ((uint64_t)(uint8_t)p[0] << 16) | ((uint64_t)(uint8_t)p[n >> 1] << 8) | (uint8_t)p[n - 1];
+    return 0;
+}
+
+uint32_t hash_bytes(const char* key, int length) {
+    uint64_t hash = HASH_SEED_0 ^ (uint64_t)length;
+    int remaining = length;
+    while (remaining >= 8) {
+        hash = mix(read_word(key) ^ HASH_SEED_1, hash ^ HASH_SEED_2);
+        key += 8;
+        remaining -= 8;
+    }
+    hash = mix(read_tail(key, remaining) ^ HASH_SEED_1, hash ^ HASH_SEED_0);
+    hash = mix(hash, (uint64_t)length ^ HASH_SEED_2);
+    return (uint32_t)(hash ^ (hash >> 32));
+}
@@ -0,0 +1,42 @@
+#include "utils/mpsc.h"
+
+void mpsc_init(mpsc_queue_t* queue) {
+    atomic_init(&queue->stub.next, NULL);
+    atomic_init(&queue->tail, &queue->stub);
+    queue->head = &queue->stub;
+}
+
+void mpsc_push(mpsc_queue_t* queue, mpsc_node_t* node) {
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    mpsc_node_t* prev = atomic_exchange_explicit(&queue->tail, node, memory_order_acq_rel);
+    // between the exchange and this store the consumer sees the queue as cut short
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+mpsc_node_t* mpsc_pop(mpsc_queue_t* queue) {
+    mpsc_node_t* head = queue->head;
+    mpsc_node_t* next = atomic_load_explicit(&head->next, memory_order_acquire);
+
+    if (head == &queue->stub) {
+        if (next == NULL)
+            return NULL;
+        queue->head = next;
+        head = next;
+        next = atomic_load_explicit(&next->next, memory_order_acquire);
+    }
+    if (next != NULL) {
+        queue->head = next;
+        return head;
+    }
+
+    // 'head' is the last node, it can only be handed out once the stub is queued behind it
+    if (head != atomic_load_explicit(&queue->tail, memory_order_acquire))
+        return NULL;
+    mpsc_push(queue, &queue->stub);
+    next = atomic_load_explicit(&head->next, memory_order_acquire);
+    if (next != NULL) {
+        queue->head = next;
+        return head;
+    }
+    return NULL;
+}
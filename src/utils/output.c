@@ -0,0 +1,136 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/output.h"
+
+void init_output(output_t* out, FILE* file, char* buffer, int capacity, bool line_buffered) {
+    out->file = file;
+    out->buffer = buffer;
+    out->capacity = capacity;
+    out->count = 0;
+    out->line_buffered = line_buffered;
+}
+
+void flush_output(output_t* out) {
+    if (out->count > 0)
+        fwrite(out->buffer, 1, out->count, out->file);
+    out->count = 0;
+}
+
+int output_write(output_t* out, const char* chars, int length) {
+    if (length > out->capacity - out->count) {
+        flush_output(out);
+        if (length > out->capacity) {
+            fwrite(chars, 1, length, out->file);
+            return length;
+        }
+    }
+    memcpy(out->buffer + out->count, chars, length);
+    out->count += length;
+    if (out->line_buffered && memchr(chars, '\n', length) != NULL)
+        flush_output(out);
+    return length;
+}
+
+int output_string(output_t* out, const char* string) {
+    return output_write(out, string, (int)strlen(string));
+}
+
+// writes the digits of 'magnitude' right-aligned into 'end', returns where they start
+static char* format_digits(char* end, uint64_t magnitude) {
+    do {
+        *--end = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    return end;
+}
+
+int output_int(output_t* out, int64_t value) {
+    char digits[20];
+    char* end = digits + sizeof digits;
+    // negated as unsigned, the smallest int has no positive counterpart
+    char* start = format_digits(end, value < 0 ? 0 - (uint64_t)value : (uint64_t)value);
+    if (value < 0)
+        *--start = '-';
+    return output_write(out, start, (int)(end - start));
+}
+
+// exact up to 10^22, every integer below 2^53 is exact as well
+static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+#define EXACT_MAX 9007199254740992.0    // 2^53
+
+/*
+ * Looks for the fewest decimals whose rounding reads back as 'value', for the numbers %g
+ * writes without an exponent. Dividing two exact doubles rounds correctly, so m / 10^k == value
+ * means the decimal m * 10^-k reads back as 'value'.
+ */
+static int format_fixed(char* digits, double value) {
+    double magnitude = fabs(value);
+    for (int decimals = 1; magnitude * powers_of_ten[decimals] < EXACT_MAX; decimals++) {
+        double scaled = nearbyint(magnitude * powers_of_ten[decimals]);
+        // the product is rounded itself, the decimal sought may be a neighbour
+        static const double neighbours[] = {0, -1, 1};
+        for (int i = 0; i < 3; i++) {
+            double candidate = scaled + neighbours[i];
+            if (candidate / powers_of_ten[decimals] != magnitude)
+                continue;
+            uint64_t mantissa = (uint64_t)candidate;
+            uint64_t scale = (uint64_t)powers_of_ten[decimals];
+            char* end = digits + 48;
+            char* start = format_digits(end, mantissa % scale);
+            while (end - start < decimals)
+                *--start = '0';
+            *--start = '.';
+            start = format_digits(start, mantissa / scale);
+            if (value < 0)
+                *--start = '-';
+            int length = (int)(end - start);
+            memmove(digits, start, length);
+            return length;
+        }
+    }
+    return 0;
+}
+
+int output_float(output_t* out, double value) {
+    char digits[48];
+    int length = 0;
+    double magnitude = fabs(value);
+    if (magnitude < 1e15 && value == trunc(value)) {
+        // integral, %g shows no decimals for these
+        if (value == 0 && signbit(value))
+            return output_write(out, "-0", 2);
+        return output_int(out, (int64_t)value);
+    }
+    if (magnitude >= 1e-4 && magnitude < 1e15)
+        length = format_fixed(digits, value);
+    if (length == 0) {
+        /*
+         * Exponents, infinities and NaN. Correctly rounded to 15 digits, a number reads back as
+         * itself if any decimal of at most 15 digits does, so the first precision that does is the shortest.
+         */
+        for (int precision = 15; precision <= 17; precision++) {
+            length = snprintf(digits, sizeof digits, "%.*g", precision, value);
+            if (precision == 17 || !isfinite(value) || strtod(digits, NULL) == value)
+                break;
+        }
+    }
+    return output_write(out, digits, length);
+}
+
+int output_format(output_t* out, const char* format, ...) {
+    char chars[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(chars, sizeof chars, format, args);
+    va_end(args);
+    if (length >= (int)sizeof chars)
+        length = sizeof chars - 1;
+    return output_write(out, chars, length);
+}
@@ -0,0 +1,449 @@
+#include <string.h>
+
+#include "utils/simd.h"
+
+#if defined(__GNUC__)
+#define CLOX_SIMD
+#define SIMD_BYTES 32
+
+/*
+ *  vec_*  -> vector registers
+ *  uvec_* -> the same vectors with alignment 1, used to load from and store to plain buffers
+ */
+typedef int64_t vec_i64_t  __attribute__((vector_size(SIMD_BYTES)));
+typedef double  vec_f64_t  __attribute__((vector_size(SIMD_BYTES)));
+typedef uint8_t vec_u8_t   __attribute__((vector_size(SIMD_BYTES)));
+typedef int8_t  vec_s8_t   __attribute__((vector_size(SIMD_BYTES)));
+typedef int64_t uvec_i64_t __attribute__((vector_size(SIMD_BYTES), aligned(1)));
+typedef double  uvec_f64_t __attribute__((vector_size(SIMD_BYTES), aligned(1)));
+typedef uint8_t uvec_u8_t  __attribute__((vector_size(SIMD_BYTES), aligned(1)));
+
+#define LANES(type) (SIMD_BYTES / sizeof(type))
+#define LOAD(uvec_type, pointer) (*(const uvec_type*)(pointer))
+#define STORE(uvec_type, pointer, v) (*(uvec_type*)(pointer) = (v))
+#endif
+
+int64_t simd_sum_i64(const int64_t* a, size_t n) {
+    size_t i = 0;
+    int64_t total = 0;
+#ifdef CLOX_SIMD
+    vec_i64_t acc = {0};
+    for (; i + LANES(int64_t) <= n; i += LANES(int64_t))
+        acc += LOAD(uvec_i64_t, a + i);
+    for (size_t l = 0; l < LANES(int64_t); l++)
+        total += acc[l];
+#endif
+    for (; i < n; i++)
+        total += a[i];
+    return total;
+}
+
+double simd_sum_f64(const double* a, size_t n) {
+    size_t i = 0;
+    double total = 0;
+#ifdef CLOX_SIMD
+    vec_f64_t acc = {0};
+    for (; i + LANES(double) <= n; i += LANES(double))
+        acc += LOAD(uvec_f64_t, a + i);
+    for (size_t l = 0; l < LANES(double); l++)
+        total += acc[l];
+#endif
+    for (; i < n; i++)
+        total += a[i];
+    return total;
+}
+
+uint64_t simd_sum_u8(const uint8_t* a, size_t n) {
+    size_t i = 0;
+    uint64_t total = 0;
+#ifdef CLOX_SIMD
+    /*
+     *  byte lanes overflow quickly, so they are summed in 64-bit lanes:
+     *  each 8-byte word is split into its even and odd bytes before adding.
+     */
+    const vec_i64_t low = {0x00ff00ff00ff00ffLL, 0x00ff00ff00ff00ffLL,
+                           0x00ff00ff00ff00ffLL, 0x00ff00ff00ff00ffLL};
+    while (i + LANES(uint8_t) <= n) {
+        /*  16-bit lanes hold at most 2 * 255 per step, flush well before they overflow  */
+        vec_i64_t acc16 = {0};
+        for (int step = 0; step < 64 && i + LANES(uint8_t) <= n; step++, i += LANES(uint8_t)) {
+            vec_i64_t v = (vec_i64_t)LOAD(uvec_u8_t, a + i);
+            acc16 += (v & low) + ((v >> 8) & low);
+        }
+        for (size_t l = 0; l < LANES(int64_t); l++) {
+            uint64_t word = (uint64_t)acc16[l];
+            total += (word & 0xffff) + ((word >> 16) & 0xffff) +
+                     ((word >> 32) & 0xffff) + (word >> 48);
+        }
+    }
+#endif
+    for (; i < n; i++)
+        total += a[i];
+    return total;
+}
+
+void simd_fill_i64(int64_t* a, size_t n, int64_t v) {
+    size_t i = 0;
+#ifdef CLOX_SIMD
+    vec_i64_t fill = (vec_i64_t){0} + v;
+    for (; i + LANES(int64_t) <= n; i += LANES(int64_t))
+        STORE(uvec_i64_t, a + i, fill);
+#endif
+    for (; i < n; i++)
+        a[i] = v;
+}
+
+void simd_fill_f64(double* a, size_t n, double v) {
+    size_t i = 0;
+#ifdef CLOX_SIMD
+    vec_f64_t fill = (vec_f64_t){0} + v;
+    for (; i + LANES(double) <= n; i += LANES(double))
+        STORE(uvec_f64_t, a + i, fill);
+#endif
+    for (; i < n; i++)
+        a[i] = v;
+}
+
+/*
+ *  Vector comparisons yield all-ones / all-zeros lanes, min and max are selected
+ *  with masks since C has no vector conditional operator.
+ */
+void simd_min_max_i64(const int64_t* a, size_t n, int64_t* min, int64_t* max) {
+    size_t i = 0;
+    int64_t lo = a[0], hi = a[0];
+#ifdef CLOX_SIMD
+    if (n >= LANES(int64_t)) {
+        vec_i64_t vlo = LOAD(uvec_i64_t, a), vhi = vlo;
+        for (i = LANES(int64_t); i + LANES(int64_t) <= n; i += LANES(int64_t)) {
+            vec_i64_t v = LOAD(uvec_i64_t, a + i);
+            vec_i64_t less = v < vlo, greater = v > vhi;
+            vlo = (v & less) | (vlo & ~less);
+            vhi = (v & greater) | (vhi & ~greater);
+        }
+        for (size_t l = 0; l < LANES(int64_t); l++) {
+            if (vlo[l] < lo) lo = vlo[l];
+            if (vhi[l] > hi) hi = vhi[l];
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] < lo) lo = a[i];
+        if (a[i] > hi) hi = a[i];
+    }
+    *min = lo;
+    *max = hi;
+}
+
+void simd_min_max_f64(const double* a, size_t n, double* min, double* max) {
+    size_t i = 0;
+    double lo = a[0], hi = a[0];
+#ifdef CLOX_SIMD
+    if (n >= LANES(double)) {
+        vec_f64_t vlo = LOAD(uvec_f64_t, a), vhi = vlo;
+        for (i = LANES(double); i + LANES(double) <= n; i += LANES(double)) {
+            vec_f64_t v = LOAD(uvec_f64_t, a + i);
+            vec_i64_t less = v < vlo, greater = v > vhi;
+            vlo = (vec_f64_t)(((vec_i64_t)v & less) | ((vec_i64_t)vlo & ~less));
+            vhi = (vec_f64_t)(((vec_i64_t)v & greater) | ((vec_i64_t)vhi & ~greater));
+        }
+        for (size_t l = 0; l < LANES(double); l++) {
+            if (vlo[l] < lo) lo = vlo[l];
+            if (vhi[l] > hi) hi = vhi[l];
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] < lo) lo = a[i];
+        if (a[i] > hi) hi = a[i];
+    }
+    *min = lo;
+    *max = hi;
+}
+
+void simd_min_max_u8(const uint8_t* a, size_t n, uint8_t* min, uint8_t* max) {
+    size_t i = 0;
+    uint8_t lo = a[0], hi = a[0];
+#ifdef CLOX_SIMD
+    if (n >= LANES(uint8_t)) {
+        vec_u8_t vlo = LOAD(uvec_u8_t, a), vhi = vlo;
+        for (i = LANES(uint8_t); i + LANES(uint8_t) <= n; i += LANES(uint8_t)) {
+            vec_u8_t v = LOAD(uvec_u8_t, a + i);
+            vec_u8_t less = (vec_u8_t)(v < vlo), greater = (vec_u8_t)(v > vhi);
+            vlo = (v & less) | (vlo & ~less);
+            vhi = (v & greater) | (vhi & ~greater);
+        }
+        for (size_t l = 0; l < LANES(uint8_t); l++) {
+            if (vlo[l] < lo) lo = vlo[l];
+            if (vhi[l] > hi) hi = vhi[l];
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (a[i] < lo) lo = a[i];
+        if (a[i] > hi) hi = a[i];
+    }
+    *min = lo;
+    *max = hi;
+}
+
+int64_t simd_dot_i64(const int64_t* a, const int64_t* b, size_t n) {
+    size_t i = 0;
+    int64_t total = 0;
+#ifdef CLOX_SIMD
+    vec_i64_t acc = {0};
+    for (; i + LANES(int64_t) <= n; i += LANES(int64_t))
+        acc += LOAD(uvec_i64_t, a + i) * LOAD(uvec_i64_t, b + i);
+    for (size_t l = 0; l < LANES(int64_t); l++)
+        total += acc[l];
+#endif
+    for (; i < n; i++)
+        total += a[i] * b[i];
+    return total;
+}
+
+double simd_dot_f64(const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    double total = 0;
+#ifdef CLOX_SIMD
+    vec_f64_t acc = {0};
+    for (; i + LANES(double) <= n; i += LANES(double))
+        acc += LOAD(uvec_f64_t, a + i) * LOAD(uvec_f64_t, b + i);
+    for (size_t l = 0; l < LANES(double); l++)
+        total += acc[l];
+#endif
+    for (; i < n; i++)
+        total += a[i] * b[i];
+    return total;
+}
+
+int64_t simd_dot_u8(const uint8_t* a, const uint8_t* b, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += (int64_t)a[i] * b[i];
+    return total;
+}
+
+#ifdef CLOX_SIMD
+#define SIMD_BINARY_LOOP(vec_type, uvec_type, elem, operator, rhs_vector, rhs_scalar) \
+    do { \
+        for (; i + LANES(elem) <= n; i += LANES(elem)) { \
+            vec_type v = LOAD(uvec_type, a + i) operator (rhs_vector); \
+            STORE(uvec_type, dst + i, v); \
+        } \
+        for (; i < n; i++) \
+            dst[i] = (elem)(a[i] operator (rhs_scalar)); \
+    } while (0)
+#else
+#define SIMD_BINARY_LOOP(vec_type, uvec_type, elem, operator, rhs_vector, rhs_scalar) \
+    do { \
+        for (; i < n; i++) \
+            dst[i] = (elem)(a[i] operator (rhs_scalar)); \
+    } while (0)
+#endif
+
+#define SIMD_BINARY(vec_type, uvec_type, elem, rhs_vector, rhs_scalar) \
+    do { \
+        size_t i = 0; \
+        switch (op) { \
+            case SIMD_ADD: SIMD_BINARY_LOOP(vec_type, uvec_type, elem, +, rhs_vector, rhs_scalar); break; \
+            case SIMD_SUB: SIMD_BINARY_LOOP(vec_type, uvec_type, elem, -, rhs_vector, rhs_scalar); break; \
+            case SIMD_MUL: SIMD_BINARY_LOOP(vec_type, uvec_type, elem, *, rhs_vector, rhs_scalar); break; \
+            case SIMD_DIV: SIMD_BINARY_LOOP(vec_type, uvec_type, elem, /, rhs_vector, rhs_scalar); break; \
+        } \
+    } while (0)
+
+void simd_binary_i64(simd_op_t op, int64_t* dst, const int64_t* a, const int64_t* b, size_t n) {
+    SIMD_BINARY(vec_i64_t, uvec_i64_t, int64_t, LOAD(uvec_i64_t, b + i), b[i]);
+}
+
+void simd_binary_f64(simd_op_t op, double* dst, const double* a, const double* b, size_t n) {
+    SIMD_BINARY(vec_f64_t, uvec_f64_t, double, LOAD(uvec_f64_t, b + i), b[i]);
+}
+
+void simd_binary_u8(simd_op_t op, uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n) {
+    SIMD_BINARY(vec_u8_t, uvec_u8_t, uint8_t, LOAD(uvec_u8_t, b + i), b[i]);
+}
+
+void simd_scalar_i64(simd_op_t op, int64_t* dst, const int64_t* a, int64_t s, size_t n) {
+#ifdef CLOX_SIMD
+    vec_i64_t vs = (vec_i64_t){0} + s;
+#endif
+    SIMD_BINARY(vec_i64_t, uvec_i64_t, int64_t, vs, s);
+}
+
+void simd_scalar_f64(simd_op_t op, double* dst, const double* a, double s, size_t n) {
+#ifdef CLOX_SIMD
+    vec_f64_t vs = (vec_f64_t){0} + s;
+#endif
+    SIMD_BINARY(vec_f64_t, uvec_f64_t, double, vs, s);
+}
+
+void simd_scalar_u8(simd_op_t op, uint8_t* dst, const uint8_t* a, uint8_t s, size_t n) {
+#ifdef CLOX_SIMD
+    vec_u8_t vs = (vec_u8_t){0} + s;
+#endif
+    SIMD_BINARY(vec_u8_t, uvec_u8_t, uint8_t, vs, s);
+}
+
+#undef SIMD_BINARY
+#undef SIMD_BINARY_LOOP
+
+uint64_t simd_popcount(const uint64_t* words, size_t n) {
+    /*  independent accumulators keep the popcnt units busy  */
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += __builtin_popcountll(words[i    ]);
+        c1 += __builtin_popcountll(words[i + 1]);
+        c2 += __builtin_popcountll(words[i + 2]);
+        c3 += __builtin_popcountll(words[i + 3]);
+    }
+    for (; i < n; i++)
+        c0 += __builtin_popcountll(words[i]);
+    return c0 + c1 + c2 + c3;
+}
+
+/*
+ *  Text scanning.
+ *
+ *  Blocks are loaded from TEXT_BYTES aligned addresses: an aligned block never straddles a page,
+ *  so reading the bytes around the terminator cannot fault. Bytes before the start pointer are masked out.
+ *  Every block is turned into a 'stop' mask with 0xff in each byte that ends the run; the vector is then
+ *  read as 64-bit words where the first stop byte is the lowest set bit (little endian only).
+ */
+#if defined(CLOX_SIMD) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CLOX_SIMD_TEXT
+/*
+ *  Byte comparisons on vectors wider than the target's registers are lowered one byte at a time,
+ *  so blocks are only 32 bytes when AVX2 is available.
+ */
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#ifdef __AVX2__
+#define TEXT_BYTES 32
+#else
+#define TEXT_BYTES 16
+#endif
+typedef uint8_t text_u8_t  __attribute__((vector_size(TEXT_BYTES)));
+typedef int8_t  text_s8_t  __attribute__((vector_size(TEXT_BYTES)));
+typedef int64_t text_i64_t __attribute__((vector_size(TEXT_BYTES)));
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define NO_SANITIZE
+#endif
+
+typedef enum {
+    SCAN_WHITESPACE,
+    SCAN_IDENTIFIER,
+    SCAN_DIGITS,
+    SCAN_LINE,
+    SCAN_QUOTE,
+} scan_class_t;
+
+static inline bool is_stop(char c, scan_class_t class) {
+    switch (class) {
+        case SCAN_WHITESPACE: return c != ' ' && c != '\t' && c != '\r' && c != '\n';
+        case SCAN_IDENTIFIER: return !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                                       (c >= '0' && c <= '9') || c == '_');
+        case SCAN_DIGITS:     return c < '0' || c > '9';
+        case SCAN_LINE:       return c == '\n' || c == 0;
+        case SCAN_QUOTE:      return c == '"' || c == 0;
+    }
+    return true;
+}
+
+#ifdef CLOX_SIMD_TEXT
+/*  one bit per byte, taken from the byte's top bit  */
+static inline __attribute__((always_inline)) uint32_t byte_mask(text_s8_t bytes) {
+#if defined(__AVX2__)
+    return (uint32_t)_mm256_movemask_epi8((__m256i)bytes);
+#elif defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8((__m128i)bytes);
+#else
+    text_i64_t words = (text_i64_t)bytes;
+    uint32_t mask = 0;
+    for (size_t l = 0; l < TEXT_BYTES / 8; l++) {
+        uint64_t top = ((uint64_t)words[l] >> 7) & 0x0101010101010101ULL;
+        mask |= (uint32_t)((top * 0x0102040810204080ULL) >> 56) << (8 * l);
+    }
+    return mask;
+#endif
+}
+
+static inline __attribute__((always_inline)) NO_SANITIZE
+const char* scan(const char* p, scan_class_t class, int* newlines) {
+    if (is_stop(*p, class))
+        return p;
+
+    int lines = 0;
+    size_t offset = (uintptr_t)p & (TEXT_BYTES - 1);
+    const uint8_t* block = (const uint8_t*)p - offset;
+    uint32_t valid = ~0U << offset;
+    for (;;) {
+        text_u8_t b = *(const text_u8_t*)block;
+        text_s8_t stop_bytes = {0};
+        switch (class) {
+            case SCAN_WHITESPACE:
+                stop_bytes = ~((b == ' ') | (b == '\t') | (b == '\r') | (b == '\n'));
+                break;
+            case SCAN_IDENTIFIER: {
+                //  setting bit 5 folds 'A'..'Z' onto 'a'..'z' without folding anything else into that range
+                text_u8_t folded = b | 0x20;
+                stop_bytes = ~(((folded >= 'a') & (folded <= 'z')) | ((b >= '0') & (b <= '9')) | (b == '_'));
+                break;
+            }
+            case SCAN_DIGITS:
+                stop_bytes = ~((b >= '0') & (b <= '9'));
+                break;
+            case SCAN_LINE:
+                stop_bytes = (b == '\n') | (b == 0);
+                break;
+            case SCAN_QUOTE:
+                stop_bytes = (b == '"') | (b == 0);
+                break;
+        }
+        uint32_t stop = byte_mask(stop_bytes) & valid;
+        uint32_t newline = newlines ? byte_mask(b == '\n') & valid : 0;
+        if (stop) {
+            //  only the newlines in front of the first stop byte were consumed
+            lines += __builtin_popcount(newline & ((stop & -stop) - 1));
+            if (newlines) *newlines += lines;
+            return (const char*)block + __builtin_ctz(stop);
+        }
+        lines += __builtin_popcount(newline);
+        valid = ~0U;
+        block += TEXT_BYTES;
+    }
+}
+#else
+static inline const char* scan(const char* p, scan_class_t class, int* newlines) {
+    for (; !is_stop(*p, class); p++) {
+        if (*p == '\n' && newlines) ++*newlines;
+    }
+    return p;
+}
+#endif
+
+NO_SANITIZE const char* simd_skip_whitespace(const char* p, int* newlines) {
+    return scan(p, SCAN_WHITESPACE, newlines);
+}
+
+NO_SANITIZE const char* simd_skip_identifier(const char* p) {
+    return scan(p, SCAN_IDENTIFIER, NULL);
+}
+
+NO_SANITIZE const char* simd_skip_digits(const char* p) {
+    return scan(p, SCAN_DIGITS, NULL);
+}
+
+NO_SANITIZE const char* simd_find_line_end(const char* p) {
+    return scan(p, SCAN_LINE, NULL);
+}
+
+NO_SANITIZE const char* simd_find_quote(const char* p, int* newlines) {
+    return scan(p, SCAN_QUOTE, newlines);
+}
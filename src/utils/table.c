@@ -53,6 +53,14 @@ void init_table(table_t *table) {
     table->entries = NULL;
 }
 
+void table_reserve(table_t* table, int count) {
+    int capacity = table->capacity;
+    while (count > capacity * TABLE_MAX_LOAD)
+        capacity = GROW_CAPACITY(capacity);
+    if (capacity != table->capacity)
+        adjust_capacity(table, capacity);
+}
+
 /*
     Be cautious about value memory leak!
     DO NOT CALL IT DIRECTLY
@@ -115,7 +123,7 @@ bool table_delete(table_t* table, object_string_t* key, void** value) {
 object_string_t* table_find_string(table_t* table, const char* chars, int length, uint32_t hash) {
     if (table->count == 0) return NULL;
 
-    uint32_t index = hash % table->capacity;
+    uint32_t index = hash & (table->capacity - 1);
     while (true) {
         table_entry_t* entry = &table->entries[index];
         if (entry->key == NULL) {
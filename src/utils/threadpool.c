@@ -0,0 +1,139 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "error/error.h"
+#include "utils/threadpool.h"
+
+typedef struct {
+    parallel_task_t task;
+    void* context;
+    int chunks;
+    atomic_int next_chunk;
+
+    uint64_t generation;
+    // workers currently holding this job, guarded by pool.lock
+    int active;
+} parallel_job_t;
+
+static struct {
+    pthread_once_t  once;
+    pthread_mutex_t lock;
+    pthread_mutex_t submit;
+    pthread_cond_t  wake;
+    pthread_cond_t  done;
+
+    pthread_t* threads;
+    int thread_count;
+    bool stopping;
+
+    uint64_t generation;
+    parallel_job_t* job;
+} pool = {
+    .once   = PTHREAD_ONCE_INIT,
+    .lock   = PTHREAD_MUTEX_INITIALIZER,
+    .submit = PTHREAD_MUTEX_INITIALIZER,
+    .wake   = PTHREAD_COND_INITIALIZER,
+    .done   = PTHREAD_COND_INITIALIZER,
+};
+
+static void run_chunks(parallel_job_t* job) {
+    for (;;) {
+        int chunk = atomic_fetch_add(&job->next_chunk, 1);
+        if (chunk >= job->chunks)
+            return;
+        job->task(job->context, chunk);
+    }
+}
+
+static void* worker(__attribute__((unused)) void* arg) {
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (!pool.stopping && (pool.job == NULL || pool.job->generation == seen))
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        if (pool.stopping)
+            break;
+
+        parallel_job_t* job = pool.job;
+        seen = job->generation;
+        job->active++;
+        pthread_mutex_unlock(&pool.lock);
+
+        run_chunks(job);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--job->active == 0)
+            pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+static void start_thread_pool() {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* configured = getenv("CLOX_THREADS");
+    if (configured != NULL)
+        threads = strtol(configured, NULL, 10);
+    if (threads < 1)
+        threads = 1;
+
+    pool.thread_count = (int)threads - 1;
+    pool.threads = pool.thread_count ? (pthread_t*)malloc(sizeof(pthread_t) * pool.thread_count) : NULL;
+    for (int i = 0; i < pool.thread_count; i++) {
+        if (pthread_create(&pool.threads[i], NULL, worker, NULL)) {
+            __CLOX_ERROR("Could not start worker threads.");
+        }
+    }
+}
+
+int parallel_threads() {
+    pthread_once(&pool.once, start_thread_pool);
+    return pool.thread_count + 1;
+}
+
+void parallel_for(int chunks, parallel_task_t task, void* context) {
+    if (chunks <= 1 || parallel_threads() == 1) {
+        for (int i = 0; i < chunks; i++)
+            task(context, i);
+        return;
+    }
+
+    parallel_job_t job;
+    job.task = task;
+    job.context = context;
+    job.chunks = chunks;
+    atomic_init(&job.next_chunk, 0);
+    job.active = 0;
+
+    // one job at a time, the pool is shared by every caller in the process
+    pthread_mutex_lock(&pool.submit);
+    pthread_mutex_lock(&pool.lock);
+    job.generation = ++pool.generation;
+    pool.job = &job;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    run_chunks(&job);
+
+    pthread_mutex_lock(&pool.lock);
+    while (job.active > 0)
+        pthread_cond_wait(&pool.done, &pool.lock);
+    pool.job = NULL;
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.submit);
+}
+
+void shutdown_thread_pool() {
+    pthread_mutex_lock(&pool.lock);
+    pool.stopping = true;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 0; i < pool.thread_count; i++)
+        pthread_join(pool.threads[i], NULL);
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.thread_count = 0;
+}
@@ -0,0 +1,246 @@
+#include <string.h>
+
+#include "constant.h"
+
+#include "utils/simd.h"
+#include "vm/vm.h"
+#include "value/native/array.h"
+#include "value/object/array.h"
+
+static value_t make_array(array_type_t type, value_t length) {
+    if (!IS_INT(length) || AS_INT(length) < 0)
+        return native_error("Array length must be a non-negative integer.");
+    if (AS_INT(length) > ARRAY_LENGTH_MAX)
+        return native_error("Array length cannot exceed %d.", ARRAY_LENGTH_MAX);
+    object_array_t* array = new_array(type, AS_INT(length));
+    if (array == NULL)
+        return native_error("Not enough memory for a %s array of %lld elements.",
+                            array_type_name(type), (long long)AS_INT(length));
+    return OBJECT_VAL(array);
+}
+
+value_t int_array_native(__attribute__((unused)) int argc, value_t* args) {
+    return make_array(ARRAY_INT, args[0]);
+}
+
+value_t float_array_native(__attribute__((unused)) int argc, value_t* args) {
+    return make_array(ARRAY_FLOAT, args[0]);
+}
+
+value_t byte_array_native(__attribute__((unused)) int argc, value_t* args) {
+    return make_array(ARRAY_BYTE, args[0]);
+}
+
+value_t bit_array_native(__attribute__((unused)) int argc, value_t* args) {
+    return make_array(ARRAY_BIT, args[0]);
+}
+
+/*
+ *  Clear the bits past the last element so that whole-word kernels,
+ *  e.g. popcount, never see them.
+ */
+static void clear_bit_tail(object_array_t* array) {
+    if (array->count & 63)
+        ((uint64_t*)array->data)[array->count >> 6] &= ((uint64_t)1 << (array->count & 63)) - 1;
+}
+
+static bool is_byte(value_t value) {
+    return IS_INT(value) && AS_INT(value) >= 0 && AS_INT(value) <= UINT8_MAX;
+}
+
+value_t array_fill_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_ARRAY(args[0]))
+        return native_error("array_fill() expects an array.");
+    object_array_t* array = AS_ARRAY(args[0]);
+    value_t v = args[1];
+    switch (array->type) {
+        case ARRAY_INT:
+            if (!IS_INT(v)) break;
+            simd_fill_i64(array->data, array->count, AS_INT(v));
+            return args[0];
+        case ARRAY_FLOAT:
+            if (!IS_NUMBER(v)) break;
+            simd_fill_f64(array->data, array->count, AS_NUMBER(v));
+            return args[0];
+        case ARRAY_BYTE:
+            if (!is_byte(v)) break;
+            memset(array->data, (int)AS_INT(v), array->count);
+            return args[0];
+        case ARRAY_BIT:
+            if (!IS_BOOL(v)) break;
+            memset(array->data, AS_BOOL(v) ? 0xff : 0, array_data_size(ARRAY_BIT, array->count));
+            clear_bit_tail(array);
+            return args[0];
+    }
+    return native_error("Cannot fill an array of %s with this value.", array_type_name(array->type));
+}
+
+value_t array_sum_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_ARRAY(args[0]))
+        return native_error("array_sum() expects an array.");
+    object_array_t* array = AS_ARRAY(args[0]);
+    switch (array->type) {
+        case ARRAY_INT:   return INT_VAL(simd_sum_i64(array->data, array->count));
+        case ARRAY_FLOAT: return FLOAT_VAL(simd_sum_f64(array->data, array->count));
+        case ARRAY_BYTE:  return INT_VAL((int64_t)simd_sum_u8(array->data, array->count));
+        case ARRAY_BIT:   return INT_VAL((int64_t)simd_popcount(array->data, ARRAY_BIT_WORDS(array->count)));
+    }
+    return NIL_VAL;
+}
+
+static value_t array_min_max(value_t input, const char* name, bool want_max) {
+    if (!IS_ARRAY(input))
+        return native_error("%s() expects an array.", name);
+    object_array_t* array = AS_ARRAY(input);
+    if (array->count == 0)
+        return native_error("%s() of an empty array.", name);
+    switch (array->type) {
+        case ARRAY_INT: {
+            int64_t lo, hi;
+            simd_min_max_i64(array->data, array->count, &lo, &hi);
+            return INT_VAL(want_max ? hi : lo);
+        }
+        case ARRAY_FLOAT: {
+            double lo, hi;
+            simd_min_max_f64(array->data, array->count, &lo, &hi);
+            return FLOAT_VAL(want_max ? hi : lo);
+        }
+        case ARRAY_BYTE: {
+            uint8_t lo, hi;
+            simd_min_max_u8(array->data, array->count, &lo, &hi);
+            return INT_VAL(want_max ? hi : lo);
+        }
+        case ARRAY_BIT:
+            break;
+    }
+    return native_error("%s() does not support bit arrays.", name);
+}
+
+value_t array_min_native(__attribute__((unused)) int argc, value_t* args) {
+    return array_min_max(args[0], "array_min", false);
+}
+
+value_t array_max_native(__attribute__((unused)) int argc, value_t* args) {
+    return array_min_max(args[0], "array_max", true);
+}
+
+static bool same_shape(object_array_t* a, object_array_t* b) {
+    return a->type == b->type && a->count == b->count;
+}
+
+value_t array_dot_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_ARRAY(args[0]) || !IS_ARRAY(args[1]))
+        return native_error("array_dot() expects two arrays.");
+    object_array_t* a = AS_ARRAY(args[0]);
+    object_array_t* b = AS_ARRAY(args[1]);
+    if (!same_shape(a, b))
+        return native_error("array_dot() expects arrays of the same type and length.");
+    switch (a->type) {
+        case ARRAY_INT:   return INT_VAL(simd_dot_i64(a->data, b->data, a->count));
+        case ARRAY_FLOAT: return FLOAT_VAL(simd_dot_f64(a->data, b->data, a->count));
+        case ARRAY_BYTE:  return INT_VAL(simd_dot_u8(a->data, b->data, a->count));
+        case ARRAY_BIT: {
+            /*  number of positions set in both bitsets  */
+            uint64_t* wa = a->data;
+            uint64_t* wb = b->data;
+            int64_t total = 0;
+            for (size_t i = 0; i < ARRAY_BIT_WORDS(a->count); i++)
+                total += __builtin_popcountll(wa[i] & wb[i]);
+            return INT_VAL(total);
+        }
+    }
+    return NIL_VAL;
+}
+
+static bool has_zero_divisor(object_array_t* array) {
+    for (int i = 0; i < array->count; i++) {
+        if ((array->type == ARRAY_INT  && ((int64_t*)array->data)[i] == 0) ||
+            (array->type == ARRAY_BYTE && ((uint8_t*)array->data)[i] == 0))
+            return true;
+    }
+    return false;
+}
+
+// INT64_MIN / -1 does not fit an int64 and traps like a zero divisor, 'b' is NULL for a scalar divisor
+static bool has_division_overflow(const int64_t* a, const int64_t* b, int64_t divisor, int count) {
+    for (int i = 0; i < count; i++) {
+        if (a[i] == INT64_MIN && (b != NULL ? b[i] : divisor) == -1)
+            return true;
+    }
+    return false;
+}
+
+static value_t array_binary(value_t* args, simd_op_t op, const char* name) {
+    if (!IS_ARRAY(args[0]) || !IS_ARRAY(args[1]))
+        return native_error("%s() expects a destination and a source array.", name);
+    object_array_t* dst = AS_ARRAY(args[0]);
+    object_array_t* a = AS_ARRAY(args[1]);
+    value_t b = args[2];
+    if (!same_shape(dst, a))
+        return native_error("%s() expects arrays of the same type and length.", name);
+    if (a->type == ARRAY_BIT)
+        return native_error("%s() does not support bit arrays.", name);
+
+    if (IS_ARRAY(b)) {
+        if (!same_shape(a, AS_ARRAY(b)))
+            return native_error("%s() expects arrays of the same type and length.", name);
+        if (op == SIMD_DIV && a->type != ARRAY_FLOAT && has_zero_divisor(AS_ARRAY(b)))
+            return native_error("Divisor cannot be zero.");
+        if (op == SIMD_DIV && a->type == ARRAY_INT && has_division_overflow(a->data, AS_ARRAY(b)->data, 0, a->count))
+            return native_error("Integer division overflows.");
+        switch (a->type) {
+            case ARRAY_INT:   simd_binary_i64(op, dst->data, a->data, AS_ARRAY(b)->data, a->count); break;
+            case ARRAY_FLOAT: simd_binary_f64(op, dst->data, a->data, AS_ARRAY(b)->data, a->count); break;
+            case ARRAY_BYTE:  simd_binary_u8 (op, dst->data, a->data, AS_ARRAY(b)->data, a->count); break;
+            case ARRAY_BIT:   break;
+        }
+        return args[0];
+    }
+
+    switch (a->type) {
+        case ARRAY_INT:
+            if (!IS_INT(b)) break;
+            if (op == SIMD_DIV && AS_INT(b) == 0)
+                return native_error("Divisor cannot be zero.");
+            if (op == SIMD_DIV && AS_INT(b) == -1 && has_division_overflow(a->data, NULL, -1, a->count))
+                return native_error("Integer division overflows.");
+            simd_scalar_i64(op, dst->data, a->data, AS_INT(b), a->count);
+            return args[0];
+        case ARRAY_FLOAT:
+            if (!IS_NUMBER(b)) break;
+            simd_scalar_f64(op, dst->data, a->data, AS_NUMBER(b), a->count);
+            return args[0];
+        case ARRAY_BYTE:
+            if (!is_byte(b)) break;
+            if (op == SIMD_DIV && AS_INT(b) == 0)
+                return native_error("Divisor cannot be zero.");
+            simd_scalar_u8(op, dst->data, a->data, (uint8_t)AS_INT(b), a->count);
+            return args[0];
+        case ARRAY_BIT:
+            break;
+    }
+    return native_error("%s() cannot combine an array of %s with this value.", name, array_type_name(a->type));
+}
+
+value_t array_add_native(__attribute__((unused)) int argc, value_t* args) {
+    return array_binary(args, SIMD_ADD, "array_add");
+}
+
+value_t array_sub_native(__attribute__((unused)) int argc, value_t* args) {
+    return array_binary(args, SIMD_SUB, "array_sub");
+}
+
+value_t array_mul_native(__attribute__((unused)) int argc, value_t* args) {
+    return array_binary(args, SIMD_MUL, "array_mul");
+}
+
+value_t array_div_native(__attribute__((unused)) int argc, value_t* args) {
+    return array_binary(args, SIMD_DIV, "array_div");
+}
+
+value_t bit_count_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_ARRAY(args[0]) || AS_ARRAY(args[0])->type != ARRAY_BIT)
+        return native_error("bit_count() expects a bit array.");
+    object_array_t* array = AS_ARRAY(args[0]);
+    return INT_VAL((int64_t)simd_popcount(array->data, ARRAY_BIT_WORDS(array->count)));
+}
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "constant.h"
+
+#include "vm/vm.h"
+#include "basic/memory.h"
+#include "value/native/bench.h"
+#include "value/native/clock.h"
+#include "value/object/class.h"
+#include "value/object/string.h"
+
+static int compare_timings(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void set_result(object_instance_t* result, const char* name, value_t value) {
+    instance_set_field(result, copy_string(name, (int)strlen(name)), value);
+}
+
+value_t bench_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_INT(args[1]) || AS_INT(args[1]) <= 0 || AS_INT(args[1]) > BENCH_ITERATIONS_MAX)
+        return native_error("bench() expects between 1 and %d iterations.", BENCH_ITERATIONS_MAX);
+    // the calls may move the stack, the arguments are read before
+    value_t callee = args[0];
+    int iterations = (int)AS_INT(args[1]);
+    int64_t* timings = ALLOCATE(int64_t, iterations);
+    if (timings == NULL)
+        return native_error("Not enough memory to benchmark.");
+
+    // a tenth of the calls again, unmeasured, to warm up caches and the slot hints of the calls inside
+    int warmup = iterations / 10 + 1;
+    uint64_t allocated = 0;
+    for (int i = -warmup; i < iterations; i++) {
+        if (i == 0)
+            allocated = vm->objects_allocated;
+        push(callee);
+        int64_t start = monotonic_ns();
+        if (!call_from_native(0)) {
+            free(timings);
+            return NONE_VAL;
+        }
+        int64_t end = monotonic_ns();
+        pop();
+        if (i >= 0)
+            timings[i] = end - start;
+    }
+    allocated = vm->objects_allocated - allocated;
+
+    // nearest rank percentiles
+    qsort(timings, iterations, sizeof(int64_t), compare_timings);
+    int64_t min = timings[0];
+    int64_t median = timings[(iterations - 1) / 2];
+    int64_t p99 = timings[(iterations * 99 + 99) / 100 - 1];
+    free(timings);
+
+    object_class_t* klass = new_class(copy_string("bench", 5));
+    push(OBJECT_VAL(klass));
+    object_instance_t* result = new_instance(klass);
+    push(OBJECT_VAL(result));
+    set_result(result, "iterations", INT_VAL(iterations));
+    set_result(result, "min", INT_VAL(min));
+    set_result(result, "median", INT_VAL(median));
+    set_result(result, "p99", INT_VAL(p99));
+    set_result(result, "allocations", FLOAT_VAL((double)allocated / iterations));
+    pop();
+    pop();
+    return OBJECT_VAL(result);
+}
@@ -2,10 +2,30 @@
 // Created by shenshuhan on 11/20/23.
 //
 
+#define _GNU_SOURCE
+
 #include <time.h>
 
 #include "value/native/clock.h"
 
+static int64_t clock_read_ns(clockid_t id) {
+    struct timespec now;
+    clock_gettime(id, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int64_t monotonic_ns() {
+    return clock_read_ns(CLOCK_MONOTONIC);
+}
+
 value_t clock_native(__attribute__((unused)) int argc, __attribute__((unused)) value_t* args) {
     return FLOAT_VAL((double)clock() / CLOCKS_PER_SEC);
 }
+
+value_t clock_ns_native(__attribute__((unused)) int argc, __attribute__((unused)) value_t* args) {
+    return INT_VAL(monotonic_ns());
+}
+
+value_t time_ns_native(__attribute__((unused)) int argc, __attribute__((unused)) value_t* args) {
+    return INT_VAL(clock_read_ns(CLOCK_REALTIME));
+}
@@ -0,0 +1,16 @@
+#include "value/native/fiber.h"
+#include "vm/runtime.h"
+
+value_t fiber_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_CLOSURE(args[0]))
+        return native_error("fiber() expects a function.");
+    if (AS_CLOSURE(args[0])->function->arity > 1)
+        return native_error("A fiber's function takes at most one argument.");
+    return OBJECT_VAL(new_fiber(AS_CLOSURE(args[0])));
+}
+
+value_t fiber_done_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_FIBER(args[0]))
+        return native_error("fiber_done() expects a fiber.");
+    return BOOL_VAL(AS_FIBER(args[0])->state == FIBER_DONE);
+}
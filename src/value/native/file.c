@@ -0,0 +1,49 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "value/native/file.h"
+#include "vm/runtime.h"
+
+value_t read_file_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_STRING(args[0]))
+        return native_error("read_file() expects a path.");
+    int fd = open(AS_CSTRING(args[0]), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NIL_VAL;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        return NIL_VAL;
+    }
+    if (info.st_size >= INT_MAX) {
+        close(fd);
+        return native_error("read_file() cannot read files of 2GB or more, read them with lines().");
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    object_string_t* string = map_string(fd, (int)info.st_size);
+    close(fd);
+    return string != NULL ? OBJECT_VAL(string) : NIL_VAL;
+}
+
+value_t lines_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_STRING(args[0]))
+        return native_error("lines() expects a path.");
+    int fd = open(AS_CSTRING(args[0]), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NIL_VAL;
+    // the kernel can read ahead further for a file read start to end
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return OBJECT_VAL(new_reader(fd));
+}
+
+value_t read_line_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_READER(args[0]))
+        return native_error("read_line() expects a reader.");
+    object_string_t* line = reader_next_line(AS_READER(args[0]));
+    return line != NULL ? OBJECT_VAL(line) : NIL_VAL;
+}
@@ -0,0 +1,214 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "constant.h"
+
+#include "value/native/io.h"
+#include "vm/runtime.h"
+
+#define LISTEN_BACKLOG 128
+
+// the task running right now, NULL outside of tasks and inside calls from natives, where I/O simply blocks
+static object_fiber_t* running_task() {
+    return vm->fiber != NULL && vm->fiber->task && vm->frame_base == 0 ? vm->fiber : NULL;
+}
+
+static bool is_descriptor(value_t value) {
+    return IS_INT(value) && AS_INT(value) >= 0 && AS_INT(value) <= INT32_MAX;
+}
+
+static void wait_descriptor(int fd, io_kind_t kind) {
+    struct pollfd descriptor = {fd, kind == IO_READ || kind == IO_ACCEPT ? POLLIN : POLLOUT, 0};
+    while (poll(&descriptor, 1, -1) < 0 && errno == EINTR)
+        ;
+}
+
+/*
+ * Runs 'operation' on 'fd'. A task that would block is parked on the descriptor and the
+ * returned value is ignored, the task is resumed with the operation's result instead.
+ */
+static value_t perform(int fd, io_operation_t operation, bool attempt) {
+    value_t result;
+    if (attempt && io_attempt(fd, &operation, &result)) {
+        free_io_operation(&operation);
+        return result;
+    }
+
+    object_fiber_t* task = running_task();
+    if (task != NULL) {
+        if (!loop_wait(&vm->loop, task, fd, operation)) {
+            free_io_operation(&operation);
+            return native_error("Another task is already waiting on descriptor %d.", fd);
+        }
+        return NIL_VAL;
+    }
+    do {
+        wait_descriptor(fd, operation.kind);
+    } while (!io_attempt(fd, &operation, &result));
+    free_io_operation(&operation);
+    return result;
+}
+
+value_t task_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_CLOSURE(args[0]))
+        return native_error("task() expects a function as the first argument.");
+    if (AS_CLOSURE(args[0])->function->arity > 1)
+        return native_error("A task's function takes at most one argument.");
+    object_fiber_t* task = new_fiber(AS_CLOSURE(args[0]));
+    task->task = true;
+    loop_ready(&vm->loop, task, args[1]);
+    return OBJECT_VAL(task);
+}
+
+value_t sleep_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_INT(args[0]) && !IS_FLOAT(args[0]))
+        return native_error("sleep() expects a number of milliseconds.");
+    double milliseconds = IS_INT(args[0]) ? (double)AS_INT(args[0]) : AS_FLOAT(args[0]);
+
+    object_fiber_t* task = running_task();
+    if (task != NULL) {
+        loop_sleep(&vm->loop, task, milliseconds);
+        return NIL_VAL;
+    }
+    if (milliseconds > 0) {
+        struct timespec time = {(time_t)(milliseconds / 1000), (long)((milliseconds - (time_t)(milliseconds / 1000) * 1000) * 1000000)};
+        while (nanosleep(&time, &time) < 0 && errno == EINTR)
+            ;
+    }
+    return NIL_VAL;
+}
+
+value_t read_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_descriptor(args[0]))
+        return native_error("read() expects a descriptor as the first argument.");
+    if (!IS_INT(args[1]) || AS_INT(args[1]) <= 0)
+        return native_error("read() expects a positive number of bytes.");
+    int length = AS_INT(args[1]) < IO_READ_MAX ? (int)AS_INT(args[1]) : IO_READ_MAX;
+    return perform((int)AS_INT(args[0]), (io_operation_t) {.kind = IO_READ, .length = length}, true);
+}
+
+value_t write_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_descriptor(args[0]))
+        return native_error("write() expects a descriptor as the first argument.");
+    if (!IS_STRING(args[1]))
+        return native_error("write() expects a string as the second argument.");
+
+    // the string may be collected while the task waits, the operation keeps its own copy
+    object_string_t* string = AS_STRING(args[1]);
+    io_operation_t operation = {.kind = IO_WRITE, .length = string->length};
+    operation.data = malloc(string->length ? string->length : 1);
+    if (operation.data == NULL)
+        return native_error("Not enough memory to write.");
+    memcpy(operation.data, string->chars, string->length);
+    // what print collected goes out before anything written to stdout directly
+    if (AS_INT(args[0]) == STDOUT_FILENO)
+        flush_native(0, NULL);
+    return perform((int)AS_INT(args[0]), operation, true);
+}
+
+value_t flush_native(__attribute__((unused)) int argc, __attribute__((unused)) value_t* args) {
+    flush_output(&vm->output);
+    fflush(stdout);
+    return NIL_VAL;
+}
+
+value_t open_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1]))
+        return native_error("open() expects a path and a mode.");
+    const char* mode = AS_STRING(args[1])->chars;
+    int flags;
+    if (strcmp(mode, "r") == 0)
+        flags = O_RDONLY;
+    else if (strcmp(mode, "w") == 0)
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+    else if (strcmp(mode, "a") == 0)
+        flags = O_WRONLY | O_CREAT | O_APPEND;
+    else
+        return native_error("open() expects the mode \"r\", \"w\" or \"a\".");
+
+    int fd = open(AS_STRING(args[0])->chars, flags | O_CLOEXEC, 0644);
+    return fd < 0 ? NIL_VAL : INT_VAL(fd);
+}
+
+value_t close_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_descriptor(args[0]))
+        return native_error("close() expects a descriptor.");
+    int fd = (int)AS_INT(args[0]);
+    loop_forget(&vm->loop, fd);
+    return BOOL_VAL(close(fd) == 0);
+}
+
+value_t pipe_native(__attribute__((unused)) int argc, __attribute__((unused)) value_t* args) {
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+        return NIL_VAL;
+    object_list_t* list = new_list(2, NIL_VAL);
+    set_list_value(list, 0, INT_VAL(fds[0]));
+    set_list_value(list, 1, INT_VAL(fds[1]));
+    return OBJECT_VAL(list);
+}
+
+value_t listen_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_INT(args[0]) || AS_INT(args[0]) < 0 || AS_INT(args[0]) > UINT16_MAX)
+        return native_error("listen() expects a port number.");
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return NIL_VAL;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)AS_INT(args[0])),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, LISTEN_BACKLOG) < 0) {
+        close(fd);
+        return NIL_VAL;
+    }
+    return INT_VAL(fd);
+}
+
+value_t accept_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_descriptor(args[0]))
+        return native_error("accept() expects a descriptor.");
+    return perform((int)AS_INT(args[0]), (io_operation_t) {.kind = IO_ACCEPT}, true);
+}
+
+value_t connect_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_STRING(args[0]))
+        return native_error("connect() expects a host as the first argument.");
+    if (!IS_INT(args[1]) || AS_INT(args[1]) < 0 || AS_INT(args[1]) > UINT16_MAX)
+        return native_error("connect() expects a port number as the second argument.");
+
+    char port[8];
+    snprintf(port, sizeof(port), "%d", (int)AS_INT(args[1]));
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_NUMERICSERV};
+    struct addrinfo* addresses = NULL;
+    if (getaddrinfo(AS_STRING(args[0])->chars, port, &hints, &addresses) != 0)
+        return NIL_VAL;
+
+    int fd = socket(addresses->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int result = fd < 0 ? -1 : connect(fd, addresses->ai_addr, addresses->ai_addrlen);
+    freeaddrinfo(addresses);
+    if (result == 0)
+        return INT_VAL(fd);
+    if (fd < 0 || errno != EINPROGRESS) {
+        if (fd >= 0)
+            close(fd);
+        return NIL_VAL;
+    }
+    // the connection is settled once the socket turns writable
+    return perform(fd, (io_operation_t) {.kind = IO_CONNECT}, false);
+}
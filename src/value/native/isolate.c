@@ -0,0 +1,186 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "component/message.h"
+#include "component/vartable.h"
+#include "value/native/isolate.h"
+#include "vm/runtime.h"
+
+typedef struct {
+    char* name;
+    int length;
+    bool mutable;
+    message_t value;
+} isolate_global_t;
+
+typedef struct {
+    message_t function;
+    message_t argument;
+    // path of the spawning module, imports inside the isolate resolve against it
+    char* path;
+    int global_count;
+    isolate_global_t* globals;
+    channel_t* result;
+} isolate_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_t* threads;
+    int count;
+    int capacity;
+} isolates = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void free_isolate(isolate_t* isolate) {
+    free_message(&isolate->function);
+    free_message(&isolate->argument);
+    for (int i = 0; i < isolate->global_count; i++) {
+        free(isolate->globals[i].name);
+        free_message(&isolate->globals[i].value);
+    }
+    free(isolate->globals);
+    free(isolate->path);
+    release_channel(isolate->result);
+    free(isolate);
+}
+
+/*
+ * Copies every global of 'module' that can be sent, the others are left out of the isolate.
+ */
+static void snapshot_globals(isolate_t* isolate, object_module_t* module) {
+    table_t* globals = &module->globals;
+    isolate->globals = malloc(sizeof(isolate_global_t) * (globals->count ? globals->count : 1));
+    for (int i = 0; i < globals->capacity; i++) {
+        table_entry_t* entry = &globals->entries[i];
+        if (entry->key == NULL || IS_ENTRY_NULL(entry->value))
+            continue;
+        isolate_global_t* global = &isolate->globals[isolate->global_count];
+        if (!pack_message(((var_t*)entry->value)->v, &global->value))
+            continue;
+        global->mutable = ((var_t*)entry->value)->mutable;
+        global->length = entry->key->length;
+        global->name = malloc(global->length + 1);
+        memcpy(global->name, entry->key->chars, global->length + 1);
+        isolate->global_count++;
+    }
+}
+
+static void* run_isolate(void* arg) {
+    isolate_t* isolate = arg;
+    vm_t* machine = new_vm();
+    vm_t* enclosing = switch_vm(machine);
+
+    if (isolate->path != NULL)
+        vm->main->path = copy_string(isolate->path, (int)strlen(isolate->path));
+    for (int i = 0; i < isolate->global_count; i++) {
+        isolate_global_t* global = &isolate->globals[i];
+        push(unpack_message(&global->value));
+        push(OBJECT_VAL(copy_string(global->name, global->length)));
+        define_global(vm->main, AS_STRING(vm->stack_top[-1]), vm->stack_top[-2], global->mutable);
+        pop();
+        pop();
+    }
+
+    push(unpack_message(&isolate->function));
+    push(unpack_message(&isolate->argument));
+    message_t result = {.kind = MESSAGE_VALUE, .value = NIL_VAL};
+    if (interpret_call(machine, 1) == INTERPRET_OK) {
+        if (!pack_message(vm->stack_top[-1], &result))
+            result = (message_t) {.kind = MESSAGE_VALUE, .value = NIL_VAL};
+        pop();
+    }
+    channel_send(isolate->result, result);
+
+    switch_vm(enclosing);
+    free_vm(machine);
+    free_isolate(isolate);
+    return NULL;
+}
+
+value_t channel_native(__attribute__((unused)) int argc, __attribute__((unused)) value_t* args) {
+    channel_t* channel = new_shared_channel();
+    object_channel_t* object = new_channel(channel);
+    release_channel(channel);
+    return OBJECT_VAL(object);
+}
+
+value_t send_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_CHANNEL(args[0]))
+        return native_error("send() expects a channel as the first argument.");
+    message_t message;
+    if (!pack_message(args[1], &message))
+        return native_error("Only nil, booleans, numbers, strings, lists, arrays, channels and functions without captured variables can be sent.");
+    channel_send(AS_CHANNEL(args[0])->channel, message);
+    return NIL_VAL;
+}
+
+value_t receive_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_CHANNEL(args[0]))
+        return native_error("receive() expects a channel.");
+    message_t message;
+    if (!channel_receive(AS_CHANNEL(args[0])->channel, &message))
+        return native_error("Another isolate is already receiving from this channel.");
+    value_t value = unpack_message(&message);
+    free_message(&message);
+    return value;
+}
+
+value_t spawn_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_CLOSURE(args[0]))
+        return native_error("spawn() expects a function as the first argument.");
+
+    isolate_t* isolate = calloc(1, sizeof(isolate_t));
+    if (!pack_message(args[0], &isolate->function)) {
+        free(isolate);
+        return native_error("spawn() cannot run a function capturing variables.");
+    }
+    if (!pack_message(args[1], &isolate->argument)) {
+        free_message(&isolate->function);
+        free(isolate);
+        return native_error("spawn() cannot copy its argument into the isolate.");
+    }
+
+    // natives run without a frame of their own, the top frame is the caller's
+    object_module_t* module = vm->frames[vm->frame_count - 1].closure->function->module;
+    snapshot_globals(isolate, module);
+    if (module->path != NULL) {
+        isolate->path = malloc(module->path->length + 1);
+        memcpy(isolate->path, module->path->chars, module->path->length + 1);
+    }
+
+    isolate->result = new_shared_channel();
+    object_channel_t* result = new_channel(isolate->result);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, run_isolate, isolate)) {
+        free_isolate(isolate);
+        return native_error("Could not start a thread for the isolate.");
+    }
+    pthread_mutex_lock(&isolates.lock);
+    if (isolates.count == isolates.capacity) {
+        isolates.capacity = isolates.capacity ? isolates.capacity * 2 : 8;
+        isolates.threads = realloc(isolates.threads, sizeof(pthread_t) * isolates.capacity);
+    }
+    isolates.threads[isolates.count++] = thread;
+    pthread_mutex_unlock(&isolates.lock);
+    return OBJECT_VAL(result);
+}
+
+void shutdown_isolates() {
+    // isolates may spawn more isolates while the earlier ones are joined
+    for (;;) {
+        pthread_mutex_lock(&isolates.lock);
+        if (isolates.count == 0) {
+            free(isolates.threads);
+            isolates.threads = NULL;
+            isolates.capacity = 0;
+            pthread_mutex_unlock(&isolates.lock);
+            return;
+        }
+        pthread_t thread = isolates.threads[--isolates.count];
+        pthread_mutex_unlock(&isolates.lock);
+        pthread_join(thread, NULL);
+    }
+}
@@ -0,0 +1,52 @@
+#include "constant.h"
+
+#include "vm/vm.h"
+#include "value/native/list.h"
+#include "value/object/list.h"
+#include "value/object/array.h"
+#include "value/object/string.h"
+#include "value/object/rope.h"
+#include "value/object/map.h"
+
+value_t len_native(__attribute__((unused)) int argc, value_t* args) {
+    if (IS_LIST(args[0]))
+        return INT_VAL(AS_LIST(args[0])->count);
+    if (IS_ARRAY(args[0]))
+        return INT_VAL(AS_ARRAY(args[0])->count);
+    if (IS_STRING(args[0]) || IS_ROPE(args[0]))
+        return INT_VAL(string_like_length(args[0]));
+    if (IS_MAP(args[0]))
+        return INT_VAL(AS_MAP(args[0])->count);
+    return native_error("len() expects a list, an array, a map or a string.");
+}
+
+value_t append_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_LIST(args[0]))
+        return native_error("append() expects a list as the first argument.");
+    if (append_list_value(AS_LIST(args[0]), args[1]))
+        return native_error("List length cannot exceed %d.", LIST_CAPACITY_MAX);
+    return args[0];
+}
+
+value_t insert_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_LIST(args[0]))
+        return native_error("insert() expects a list as the first argument.");
+    if (!IS_INT(args[1]))
+        return native_error("Only integers can be array indices.");
+
+    object_list_t* list = AS_LIST(args[0]);
+    if (AS_INT(args[1]) < 0 || AS_INT(args[1]) > list->count)
+        return native_error("Array index out of bound.");
+    if (insert_list_value(list, AS_INT(args[1]), args[2]))
+        return native_error("List length cannot exceed %d.", LIST_CAPACITY_MAX);
+    return args[0];
+}
+
+value_t pop_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_LIST(args[0]))
+        return native_error("pop() expects a list.");
+    value_t value;
+    if (pop_list_value(AS_LIST(args[0]), &value))
+        return native_error("Cannot pop from an empty list.");
+    return value;
+}
@@ -0,0 +1,39 @@
+#include "constant.h"
+
+#include "vm/vm.h"
+#include "value/native/map.h"
+#include "value/object/list.h"
+#include "value/object/map.h"
+
+value_t keys_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_MAP(args[0]))
+        return native_error("keys() expects a map.");
+    object_map_t* map = AS_MAP(args[0]);
+    object_list_t* keys = new_list(map->count, NIL_VAL);
+    if (keys == NULL)
+        return native_error("List length cannot exceed %d.", LIST_CAPACITY_MAX);
+    int count = 0;
+    for (int i = 0; i < map->capacity; i++) {
+        if (map_slot_full(map, i))
+            set_list_value(keys, count++, map->entries[i].key);
+    }
+    return OBJECT_VAL(keys);
+}
+
+value_t has_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_MAP(args[0]))
+        return native_error("has() expects a map as the first argument.");
+    value_t key, value;
+    if (!map_key(args[1], &key))
+        return native_error("Map keys must be numbers, strings or booleans.");
+    return BOOL_VAL(map_get(AS_MAP(args[0]), key, &value));
+}
+
+value_t remove_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_MAP(args[0]))
+        return native_error("remove() expects a map as the first argument.");
+    value_t key;
+    if (!map_key(args[1], &key))
+        return native_error("Map keys must be numbers, strings or booleans.");
+    return BOOL_VAL(map_remove(AS_MAP(args[0]), key));
+}
@@ -0,0 +1,66 @@
+#include <math.h>
+
+#include "vm/vm.h"
+#include "value/native/math.h"
+
+value_t sqrt_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_NUMBER(args[0]))
+        return native_error("sqrt() expects a number.");
+    return FLOAT_VAL(sqrt(AS_NUMBER(args[0])));
+}
+
+value_t floor_native(__attribute__((unused)) int argc, value_t* args) {
+    if (IS_INT(args[0]))
+        return args[0];
+    if (!IS_FLOAT(args[0]))
+        return native_error("floor() expects a number.");
+    double result = floor(AS_FLOAT(args[0]));
+    // the range check is false for NaN as well
+    if (!(result >= -0x1p63 && result < 0x1p63))
+        return native_error("floor() result does not fit an int.");
+    return INT_VAL((int64_t)result);
+}
+
+value_t abs_native(__attribute__((unused)) int argc, value_t* args) {
+    if (IS_INT(args[0])) {
+        // negated as unsigned, so the smallest int wraps around instead of overflowing
+        uint64_t magnitude = (uint64_t)AS_INT(args[0]);
+        return INT_VAL(AS_INT(args[0]) < 0 ? (int64_t)(0 - magnitude) : AS_INT(args[0]));
+    }
+    if (!IS_FLOAT(args[0]))
+        return native_error("abs() expects a number.");
+    return FLOAT_VAL(fabs(AS_FLOAT(args[0])));
+}
+
+value_t min_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_NUMBER(args[0]) || !IS_NUMBER(args[1]))
+        return native_error("min() expects two numbers.");
+    if (IS_INT(args[0]) && IS_INT(args[1]))
+        return AS_INT(args[1]) < AS_INT(args[0]) ? args[1] : args[0];
+    return AS_NUMBER(args[1]) < AS_NUMBER(args[0]) ? args[1] : args[0];
+}
+
+value_t max_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_NUMBER(args[0]) || !IS_NUMBER(args[1]))
+        return native_error("max() expects two numbers.");
+    if (IS_INT(args[0]) && IS_INT(args[1]))
+        return AS_INT(args[1]) > AS_INT(args[0]) ? args[1] : args[0];
+    return AS_NUMBER(args[1]) > AS_NUMBER(args[0]) ? args[1] : args[0];
+}
+
+value_t pow_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!IS_NUMBER(args[0]) || !IS_NUMBER(args[1]))
+        return native_error("pow() expects two numbers.");
+    if (IS_INT(args[0]) && IS_INT(args[1]) && AS_INT(args[1]) >= 0) {
+        // squaring on unsigned integers, overflow wraps around like the other integer operators
+        uint64_t base = (uint64_t)AS_INT(args[0]);
+        uint64_t result = 1;
+        for (int64_t exponent = AS_INT(args[1]); exponent > 0; exponent >>= 1) {
+            if (exponent & 1)
+                result *= base;
+            base *= base;
+        }
+        return INT_VAL((int64_t)result);
+    }
+    return FLOAT_VAL(pow(AS_NUMBER(args[0]), AS_NUMBER(args[1])));
+}
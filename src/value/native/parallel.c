@@ -0,0 +1,339 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "constant.h"
+
+#include "utils/simd.h"
+#include "utils/threadpool.h"
+#include "vm/vm.h"
+#include "value/native/parallel.h"
+#include "value/object/array.h"
+#include "value/object/string.h"
+
+/*
+ *  All kernels share the same shape: the input is split into 'chunks' contiguous ranges,
+ *  every chunk writes its own slot of 'partial', and the calling thread combines them.
+ *  Nothing below the dispatch touches the Lox heap, every object is resolved beforehand.
+ */
+typedef struct {
+    array_type_t type;
+    size_t count;
+    int chunks;
+
+    const void* src;
+    void* dst;
+
+    int op;
+    int64_t i_scalar;
+    double  f_scalar;
+
+    int bins;
+    double lo;
+    double hi;
+    int64_t* histograms;
+
+    int64_t i_partial[PARALLEL_CHUNKS_MAX];
+    double  f_partial[PARALLEL_CHUNKS_MAX];
+} kernel_t;
+
+static int plan_chunks(size_t count) {
+    if (count < PARALLEL_MIN_ELEMENTS)
+        return 1;
+    size_t chunks = count / PARALLEL_CHUNK_MIN;
+    size_t wanted = (size_t)parallel_threads() * 4;
+    if (chunks > wanted) chunks = wanted;
+    if (chunks > PARALLEL_CHUNKS_MAX) chunks = PARALLEL_CHUNKS_MAX;
+    return chunks ? (int)chunks : 1;
+}
+
+static void chunk_range(kernel_t* kernel, int chunk, size_t* from, size_t* to) {
+    *from = kernel->count * chunk / kernel->chunks;
+    *to = kernel->count * (chunk + 1) / kernel->chunks;
+}
+
+static bool is_numeric_array(value_t value) {
+    return IS_ARRAY(value) &&
+        (AS_ARRAY(value)->type == ARRAY_INT || AS_ARRAY(value)->type == ARRAY_FLOAT);
+}
+
+static kernel_t* new_kernel(object_array_t* src) {
+    kernel_t* kernel = (kernel_t*)calloc(1, sizeof(kernel_t));
+    if (kernel == NULL)
+        return NULL;
+    kernel->type = src->type;
+    kernel->count = src->count;
+    kernel->src = src->data;
+    kernel->chunks = plan_chunks(src->count);
+    return kernel;
+}
+
+/******************** SUM ********************/
+
+static void sum_task(void* context, int chunk) {
+    kernel_t* kernel = context;
+    size_t from, to;
+    chunk_range(kernel, chunk, &from, &to);
+    if (kernel->type == ARRAY_INT)
+        kernel->i_partial[chunk] = simd_sum_i64((const int64_t*)kernel->src + from, to - from);
+    else
+        kernel->f_partial[chunk] = simd_sum_f64((const double*)kernel->src + from, to - from);
+}
+
+value_t par_sum_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_numeric_array(args[0]))
+        return native_error("par_sum() expects an int or float array.");
+    kernel_t* kernel = new_kernel(AS_ARRAY(args[0]));
+    if (kernel == NULL)
+        return native_error("Not enough memory for par_sum().");
+
+    parallel_for(kernel->chunks, sum_task, kernel);
+
+    int64_t i_total = 0;
+    double f_total = 0;
+    for (int i = 0; i < kernel->chunks; i++) {
+        i_total += kernel->i_partial[i];
+        f_total += kernel->f_partial[i];
+    }
+    value_t result = kernel->type == ARRAY_INT ? INT_VAL(i_total) : FLOAT_VAL(f_total);
+    free(kernel);
+    return result;
+}
+
+/******************** MAP ********************/
+
+static bool parse_arithmetic(value_t op, simd_op_t* result) {
+    if (!IS_STRING(op) || AS_STRING(op)->length != 1)
+        return false;
+    switch (AS_CSTRING(op)[0]) {
+        case '+': *result = SIMD_ADD; return true;
+        case '-': *result = SIMD_SUB; return true;
+        case '*': *result = SIMD_MUL; return true;
+        case '/': *result = SIMD_DIV; return true;
+        default:  return false;
+    }
+}
+
+static void map_task(void* context, int chunk) {
+    kernel_t* kernel = context;
+    size_t from, to;
+    chunk_range(kernel, chunk, &from, &to);
+    if (kernel->type == ARRAY_INT)
+        simd_scalar_i64(kernel->op, (int64_t*)kernel->dst + from,
+                        (const int64_t*)kernel->src + from, kernel->i_scalar, to - from);
+    else
+        simd_scalar_f64(kernel->op, (double*)kernel->dst + from,
+                        (const double*)kernel->src + from, kernel->f_scalar, to - from);
+}
+
+value_t par_map_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_numeric_array(args[0]) || !is_numeric_array(args[1]))
+        return native_error("par_map() expects a destination and a source int or float array.");
+    object_array_t* dst = AS_ARRAY(args[0]);
+    object_array_t* src = AS_ARRAY(args[1]);
+    if (dst->type != src->type || dst->count != src->count)
+        return native_error("par_map() expects arrays of the same type and length.");
+    simd_op_t op;
+    if (!parse_arithmetic(args[2], &op))
+        return native_error("par_map() operator must be one of \"+\", \"-\", \"*\", \"/\".");
+    if (src->type == ARRAY_INT && !IS_INT(args[3]))
+        return native_error("par_map() on an int array expects an integer operand.");
+    if (!IS_NUMBER(args[3]))
+        return native_error("par_map() expects a number operand.");
+    if (src->type == ARRAY_INT && op == SIMD_DIV && AS_INT(args[3]) == 0)
+        return native_error("Divisor cannot be zero.");
+
+    kernel_t* kernel = new_kernel(src);
+    if (kernel == NULL)
+        return native_error("Not enough memory for par_map().");
+    kernel->dst = dst->data;
+    kernel->op = op;
+    kernel->i_scalar = IS_INT(args[3]) ? AS_INT(args[3]) : 0;
+    kernel->f_scalar = AS_NUMBER(args[3]);
+
+    parallel_for(kernel->chunks, map_task, kernel);
+    free(kernel);
+    return args[0];
+}
+
+/******************** COUNT ********************/
+
+typedef enum {
+    CMP_LESS, CMP_LESS_EQUAL, CMP_GREATER, CMP_GREATER_EQUAL, CMP_EQUAL, CMP_NOT_EQUAL,
+} compare_t;
+
+static bool parse_compare(value_t op, compare_t* result) {
+    static const char* names[] = {"<", "<=", ">", ">=", "==", "!="};
+    if (!IS_STRING(op))
+        return false;
+    for (int i = 0; i < 6; i++) {
+        if (!strcmp(AS_CSTRING(op), names[i])) {
+            *result = (compare_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#define COUNT_LOOP(type, src, scalar) \
+    do { \
+        const type* a = (const type*)(src); \
+        switch (kernel->op) { \
+            case CMP_LESS:          for (size_t i = from; i < to; i++) n += a[i] <  (scalar); break; \
+            case CMP_LESS_EQUAL:    for (size_t i = from; i < to; i++) n += a[i] <= (scalar); break; \
+            case CMP_GREATER:       for (size_t i = from; i < to; i++) n += a[i] >  (scalar); break; \
+            case CMP_GREATER_EQUAL: for (size_t i = from; i < to; i++) n += a[i] >= (scalar); break; \
+            case CMP_EQUAL:         for (size_t i = from; i < to; i++) n += a[i] == (scalar); break; \
+            case CMP_NOT_EQUAL:     for (size_t i = from; i < to; i++) n += a[i] != (scalar); break; \
+        } \
+    } while (0)
+
+static void count_task(void* context, int chunk) {
+    kernel_t* kernel = context;
+    size_t from, to;
+    chunk_range(kernel, chunk, &from, &to);
+    int64_t n = 0;
+    if (kernel->type == ARRAY_INT)
+        COUNT_LOOP(int64_t, kernel->src, kernel->i_scalar);
+    else
+        COUNT_LOOP(double, kernel->src, kernel->f_scalar);
+    kernel->i_partial[chunk] = n;
+}
+
+#undef COUNT_LOOP
+
+value_t par_count_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_numeric_array(args[0]))
+        return native_error("par_count() expects an int or float array.");
+    compare_t op;
+    if (!parse_compare(args[1], &op))
+        return native_error("par_count() comparison must be one of \"<\", \"<=\", \">\", \">=\", \"==\", \"!=\".");
+    if (!IS_NUMBER(args[2]))
+        return native_error("par_count() expects a number to compare with.");
+    object_array_t* src = AS_ARRAY(args[0]);
+    if (src->type == ARRAY_INT && !IS_INT(args[2]))
+        return native_error("par_count() on an int array expects an integer operand.");
+
+    kernel_t* kernel = new_kernel(src);
+    if (kernel == NULL)
+        return native_error("Not enough memory for par_count().");
+    kernel->op = op;
+    kernel->i_scalar = IS_INT(args[2]) ? AS_INT(args[2]) : 0;
+    kernel->f_scalar = AS_NUMBER(args[2]);
+
+    parallel_for(kernel->chunks, count_task, kernel);
+
+    int64_t total = 0;
+    for (int i = 0; i < kernel->chunks; i++)
+        total += kernel->i_partial[i];
+    free(kernel);
+    return INT_VAL(total);
+}
+
+/******************** PREFIX SUM ********************/
+
+/*
+ *  Two passes: every chunk sums its range, the caller turns chunk sums into offsets,
+ *  then every chunk scans its range starting from its offset.
+ */
+static void scan_task(void* context, int chunk) {
+    kernel_t* kernel = context;
+    size_t from, to;
+    chunk_range(kernel, chunk, &from, &to);
+    if (kernel->type == ARRAY_INT) {
+        const int64_t* a = kernel->src;
+        int64_t* out = kernel->dst;
+        int64_t running = kernel->i_partial[chunk];
+        for (size_t i = from; i < to; i++)
+            out[i] = running += a[i];
+    } else {
+        const double* a = kernel->src;
+        double* out = kernel->dst;
+        double running = kernel->f_partial[chunk];
+        for (size_t i = from; i < to; i++)
+            out[i] = running += a[i];
+    }
+}
+
+value_t par_prefix_sum_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_numeric_array(args[0]) || !is_numeric_array(args[1]))
+        return native_error("par_prefix_sum() expects a destination and a source int or float array.");
+    object_array_t* dst = AS_ARRAY(args[0]);
+    object_array_t* src = AS_ARRAY(args[1]);
+    if (dst->type != src->type || dst->count != src->count)
+        return native_error("par_prefix_sum() expects arrays of the same type and length.");
+
+    kernel_t* kernel = new_kernel(src);
+    if (kernel == NULL)
+        return native_error("Not enough memory for par_prefix_sum().");
+    kernel->dst = dst->data;
+
+    if (kernel->chunks > 1) {
+        parallel_for(kernel->chunks, sum_task, kernel);
+        int64_t i_offset = 0;
+        double f_offset = 0;
+        for (int i = 0; i < kernel->chunks; i++) {
+            int64_t i_sum = kernel->i_partial[i];
+            double f_sum = kernel->f_partial[i];
+            kernel->i_partial[i] = i_offset;
+            kernel->f_partial[i] = f_offset;
+            i_offset += i_sum;
+            f_offset += f_sum;
+        }
+    }
+    parallel_for(kernel->chunks, scan_task, kernel);
+    free(kernel);
+    return args[0];
+}
+
+/******************** HISTOGRAM ********************/
+
+static void histogram_task(void* context, int chunk) {
+    kernel_t* kernel = context;
+    size_t from, to;
+    chunk_range(kernel, chunk, &from, &to);
+    int64_t* bins = kernel->histograms + (size_t)chunk * kernel->bins;
+    double scale = kernel->bins / (kernel->hi - kernel->lo);
+    for (size_t i = from; i < to; i++) {
+        double x = kernel->type == ARRAY_INT ?
+                (double)((const int64_t*)kernel->src)[i] : ((const double*)kernel->src)[i];
+        if (!(x >= kernel->lo && x < kernel->hi))
+            continue;
+        int bin = (int)((x - kernel->lo) * scale);
+        bins[bin < kernel->bins ? bin : kernel->bins - 1]++;
+    }
+}
+
+value_t par_histogram_native(__attribute__((unused)) int argc, value_t* args) {
+    if (!is_numeric_array(args[0]))
+        return native_error("par_histogram() expects an int or float array.");
+    if (!IS_INT(args[1]) || AS_INT(args[1]) <= 0 || AS_INT(args[1]) > ARRAY_LENGTH_MAX)
+        return native_error("par_histogram() expects a positive number of bins.");
+    if (!IS_NUMBER(args[2]) || !IS_NUMBER(args[3]) || !(AS_NUMBER(args[2]) < AS_NUMBER(args[3])))
+        return native_error("par_histogram() expects numbers lo < hi.");
+
+    kernel_t* kernel = new_kernel(AS_ARRAY(args[0]));
+    if (kernel == NULL)
+        return native_error("Not enough memory for par_histogram().");
+    kernel->bins = (int)AS_INT(args[1]);
+    kernel->lo = AS_NUMBER(args[2]);
+    kernel->hi = AS_NUMBER(args[3]);
+    // one private histogram per chunk, merged afterwards
+    kernel->histograms = (int64_t*)calloc((size_t)kernel->chunks * kernel->bins, sizeof(int64_t));
+    object_array_t* result = new_array(ARRAY_INT, kernel->bins);
+    if (kernel->histograms == NULL || result == NULL) {
+        free(kernel->histograms);
+        free(kernel);
+        return native_error("Not enough memory for par_histogram().");
+    }
+
+    parallel_for(kernel->chunks, histogram_task, kernel);
+
+    int64_t* counts = result->data;
+    for (int c = 0; c < kernel->chunks; c++) {
+        for (int b = 0; b < kernel->bins; b++)
+            counts[b] += kernel->histograms[(size_t)c * kernel->bins + b];
+    }
+    free(kernel->histograms);
+    free(kernel);
+    return OBJECT_VAL(result);
+}
@@ -40,6 +40,7 @@ value_t type_native(__attribute__((unused)) int argc, value_t* args) {
                     strcpy(buff, "native-function");
                     break;
                 case OBJ_STRING:
+                case OBJ_ROPE:
                     strcpy(buff, "string");
                     break;
                 case OBJ_INSTANCE:
@@ -48,6 +49,21 @@ value_t type_native(__attribute__((unused)) int argc, value_t* args) {
                 case OBJ_LIST:
                     strcpy(buff, "list");
                     break;
+                case OBJ_ARRAY:
+                    strcpy(buff, "array");
+                    break;
+                case OBJ_CHANNEL:
+                    strcpy(buff, "channel");
+                    break;
+                case OBJ_FIBER:
+                    strcpy(buff, "fiber");
+                    break;
+                case OBJ_READER:
+                    strcpy(buff, "reader");
+                    break;
+                case OBJ_MAP:
+                    strcpy(buff, "map");
+                    break;
                 default:
                     strcpy(buff, "undefined");
             }
@@ -1,70 +1,132 @@
 #include <stdio.h>
+#include <sys/mman.h>
 
 #include "common.h"
 #include "basic/memory.h"
 #include "vm/runtime.h"
 #include "value/object/class.h"
+#include "value/object/module.h"
+#include "component/vartable.h"
 #include "component/valuetable.h"
 
-list_t temporary_objs;
+// writes "<'prefix' 'name'>", names can be as long as any string
+static int write_named(output_t* out, const char* prefix, object_string_t* name) {
+    int len = output_string(out, prefix);
+    len += output_write(out, name->chars, name->length);
+    len += output_string(out, ">");
+    return len;
+}
 
-static int print_function(object_function_t* func) {
+static int write_function(output_t* out, object_function_t* func) {
     if (!func->name) {
-        return printf("<script>");
+        return output_string(out, "<script>");
     }
-    return printf("<fn %s>", func->name->chars);
+    return write_named(out, "<fn ", func->name);
 }
 
-int print_object(value_t value) {
+int write_object(output_t* out, value_t value) {
     switch(OBJ_TYPE(value)) {
         case OBJ_LIST: {
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
             int len = 0;
             object_list_t* list = AS_LIST(value);
-            len += printf("[");
-            for (int i = 0; i < MIN(list->capacity, 10); i++) {
-                len += printf(" ");
+            len += output_string(out, "[");
+            for (int i = 0; i < MIN(list->count, 10); i++) {
+                len += output_string(out, " ");
                 if (IS_NONE(list->list[i]))
-                    len += print_value(list->initial);
+                    len += write_value(out, list->initial);
                 else
-                    len += print_value(list->list[i]);
-                len += printf(", ");
+                    len += write_value(out, list->list[i]);
+                len += output_string(out, ", ");
             }
-            if (list->capacity > 10)
-                len += printf("... ");
-            len += printf("]");
+            if (list->count > 10)
+                len += output_string(out, "... ");
+            len += output_string(out, "]");
             return len;
 #undef MIN
         }
+        case OBJ_ARRAY: {
+            int len = 0;
+            object_array_t* array = AS_ARRAY(value);
+            len += output_string(out, array_type_name(array->type));
+            len += output_string(out, "[");
+            for (int i = 0; i < array->count && i < 10; i++) {
+                value_t element;
+                get_array_value(array, i, &element);
+                len += output_string(out, " ");
+                len += write_value(out, element);
+                len += output_string(out, ", ");
+            }
+            if (array->count > 10)
+                len += output_string(out, "... ");
+            len += output_string(out, "]");
+            return len;
+        }
         case OBJ_CLASS:
-            return printf("<class %s>", AS_CLASS(value)->name->chars);
+            return write_named(out, "<class ", AS_CLASS(value)->name);
         case OBJ_BOUND_METHOD: {
             int len = 0;
-            len += printf("<bound method ");
-            len += print_function(AS_BOUND_METHOD(value)->method->function);
-            len += printf(">");
+            len += output_string(out, "<bound method ");
+            len += write_function(out, AS_BOUND_METHOD(value)->method->function);
+            len += output_string(out, ">");
             return len;
         }
         case OBJ_INSTANCE:
-            return printf("<instance %s>", AS_INSTANCE(value)->klass->name->chars);
+            return write_named(out, "<instance ", AS_INSTANCE(value)->klass->name);
         case OBJ_STRING:
-            return printf("%s", AS_CSTRING(value));
+            return output_write(out, AS_CSTRING(value), AS_STRING(value)->length);
+        case OBJ_ROPE: {
+            object_string_t* flat = flatten_rope(AS_ROPE(value));
+            return output_write(out, flat->chars, flat->length);
+        }
         case OBJ_FUNCTION:
-            return print_function(AS_FUNCTION(value));
+            return write_function(out, AS_FUNCTION(value));
         case OBJ_NATIVE:
-            return printf("<native fn>");
+            return output_string(out, "<native fn>");
         case OBJ_CLOSURE: {
             int len = 0;
             void* enclosed = AS_CLOSURE(value)->function;
-            len += printf("<closure ");
-            len += printf(" [%p] ", enclosed);
+            len += output_string(out, "<closure ");
+            len += output_format(out, " [%p] ", enclosed);
             if (enclosed)
-                len += print_function(AS_CLOSURE(value)->function);
-            len += printf(">");
+                len += write_function(out, AS_CLOSURE(value)->function);
+            len += output_string(out, ">");
             return len;
         }
         case OBJ_UPVALUE:
-            return printf("[upvalue]");
+            return output_string(out, "[upvalue]");
+        case OBJ_MODULE: {
+            object_string_t* path = AS_MODULE(value)->path;
+            if (path == NULL)
+                return output_string(out, "<module <script>>");
+            return write_named(out, "<module ", path);
+        }
+        case OBJ_CHANNEL:
+            return output_string(out, "<channel>");
+        case OBJ_FIBER:
+            return output_string(out, "<fiber>");
+        case OBJ_READER:
+            return output_string(out, "<reader>");
+        case OBJ_MAP: {
+            int len = 0;
+            int written = 0;
+            object_map_t* map = AS_MAP(value);
+            len += output_string(out, "{");
+            for (int i = 0; i < map->capacity && written < 10; i++) {
+                if (!map_slot_full(map, i))
+                    continue;
+                len += output_string(out, " ");
+                len += write_value(out, map->entries[i].key);
+                len += output_string(out, ": ");
+                len += write_value(out, map->entries[i].value);
+                len += output_string(out, ", ");
+                written++;
+            }
+            if (map->count > 10)
+                len += output_string(out, "... ");
+            len += output_string(out, "}");
+            return len;
+        }
     }
     return 0;
 }
@@ -77,15 +139,18 @@ void blacken_object(object_t* object) {
 #endif
     switch (object->type) {
         case OBJ_LIST: {
-            object_list_t* list = (object_list_t*)object;
-            mark_value(list->initial);
-            for (int i = 0; i < list->capacity; i++)
-                mark_value(list->list[i]);
+            mark_list_values((object_list_t*)object);
+            break;
+        }
+        case OBJ_MAP: {
+            mark_map_entries((object_map_t*)object);
             break;
         }
         case OBJ_CLASS: {
             object_class_t* klass = (object_class_t*)object;
             mark_table_value(&klass->methods);
+            for (int i = 0; i < klass->method_count; i++)
+                mark_object((object_t*)klass->vtable[i].method);
             mark_object((object_t*)klass->name);
             break;
         }
@@ -109,16 +174,44 @@ void blacken_object(object_t* object) {
             }
             break;
         }
+        case OBJ_ROPE: {
+            object_rope_t* rope = (object_rope_t*)object;
+            mark_object(rope->left);
+            mark_object(rope->right);
+            mark_object((object_t*)rope->flat);
+            break;
+        }
         case OBJ_FUNCTION: {
             object_function_t *function = (object_function_t*)object;
             mark_object((object_t*)function->name);
             mark_array(&function->chunk.constants);
+            mark_object((object_t*)function->module);
+            break;
         }
         case OBJ_UPVALUE:
             mark_value(((object_upvalue_t*)object)->closed);
+            mark_object((object_t*)((object_upvalue_t*)object)->fiber);
+            break;
+        case OBJ_MODULE: {
+            object_module_t* module = (object_module_t*)object;
+            mark_object((object_t*)module->path);
+            mark_table_var(&module->globals);
             break;
+        }
+        case OBJ_FIBER: {
+            object_fiber_t* fiber = (object_fiber_t*)object;
+            mark_object((object_t*)fiber->closure);
+            mark_object((object_t*)fiber->caller);
+            // the running fiber's stack is the VM's, its saved copy is stale
+            if (fiber != vm->fiber)
+                mark_call_stack(&fiber->stack);
+            break;
+        }
         case OBJ_NATIVE:
         case OBJ_STRING:
+        case OBJ_ARRAY:
+        case OBJ_CHANNEL:
+        case OBJ_READER:
             break;
     }
 }
@@ -129,7 +222,8 @@ object_t* allocate_object(size_t size, object_type_t type) {
     object->type = type;
     object->is_marked = false;
     list_link_init(&object->link);
-    list_insert_head(&temporary_objs, &object->link);
+    list_insert_head(&vm->temporary_objs, &object->link);
+    vm->objects_allocated++;
 
 #ifdef DEBUG_LOG_GC
     printf("%p allocate %zu for %d\n", (void*)object, size, type);
@@ -139,7 +233,7 @@ object_t* allocate_object(size_t size, object_type_t type) {
 }
 
 void merge_temporary() {
-    list_insert_multi(&vm.obj, &temporary_objs);
+    list_insert_multi(&vm->obj, &vm->temporary_objs);
 }
 
 void free_object(object_t *obj) {
@@ -150,14 +244,20 @@ void free_object(object_t *obj) {
 
     switch (obj->type) {
         case OBJ_LIST: {
-            object_list_t *list = (object_list_t*)obj;
-            FREE_ARRAY(value_t, list->list, list->capacity);
+            free_list_storage((object_list_t*)obj);
             FREE(object_list_t, obj);
             break;
         }
+        case OBJ_ARRAY: {
+            object_array_t *array = (object_array_t*)obj;
+            free(array->data);
+            FREE(object_array_t, obj);
+            break;
+        }
         case OBJ_CLASS: {
             object_class_t *klass = (object_class_t*)obj;
             free_table_value(&klass->methods);
+            FREE_ARRAY(method_slot_t, klass->vtable, klass->method_capacity);
             FREE(object_class_t, obj);
             break;
         }
@@ -180,10 +280,17 @@ void free_object(object_t *obj) {
         }
         case OBJ_STRING: {
             object_string_t *string = (object_string_t*)obj;
-            FREE_ARRAY(char, string->chars, string->length + 1);
+            if (string->mapped)
+                munmap(string->chars, string->length + 1);
+            else
+                FREE_ARRAY(char, string->chars, string->length + 1);
             FREE(object_string_t, obj);
             break;
         }
+        case OBJ_ROPE: {
+            FREE(object_rope_t, obj);
+            break;
+        }
         case OBJ_NATIVE: {
             FREE(object_native_func_t, obj);
             break;
@@ -198,6 +305,33 @@ void free_object(object_t *obj) {
             FREE(object_upvalue_t, obj);
             break;
         }
+        case OBJ_MODULE: {
+            free_table_var(&((object_module_t*)obj)->globals);
+            FREE(object_module_t, obj);
+            break;
+        }
+        case OBJ_CHANNEL: {
+            release_channel(((object_channel_t*)obj)->channel);
+            FREE(object_channel_t, obj);
+            break;
+        }
+        case OBJ_FIBER: {
+            free_call_stack(&((object_fiber_t*)obj)->stack);
+            FREE(object_fiber_t, obj);
+            break;
+        }
+        case OBJ_READER: {
+            object_reader_t* reader = (object_reader_t*)obj;
+            close_reader(reader);
+            free(reader->buffer);
+            FREE(object_reader_t, obj);
+            break;
+        }
+        case OBJ_MAP: {
+            free_map_storage((object_map_t*)obj);
+            FREE(object_map_t, obj);
+            break;
+        }
         default: return;
     }
 }
\ No newline at end of file
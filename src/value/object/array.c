@@ -0,0 +1,91 @@
+#include <stdlib.h>
+
+#include "constant.h"
+
+#include "value/object/array.h"
+#include "value/object.h"
+
+size_t array_data_size(array_type_t type, uint32_t count) {
+    switch (type) {
+        case ARRAY_INT:   return count * sizeof(int64_t);
+        case ARRAY_FLOAT: return count * sizeof(double);
+        case ARRAY_BYTE:  return count * sizeof(uint8_t);
+        case ARRAY_BIT:   return ARRAY_BIT_WORDS(count) * sizeof(uint64_t);
+    }
+    return 0;
+}
+
+const char* array_type_name(array_type_t type) {
+    switch (type) {
+        case ARRAY_INT:   return "int";
+        case ARRAY_FLOAT: return "float";
+        case ARRAY_BYTE:  return "byte";
+        case ARRAY_BIT:   return "bit";
+    }
+    return "unknown";
+}
+
+object_array_t* new_array(array_type_t type, uint32_t count) {
+    if (count > ARRAY_LENGTH_MAX)
+        return NULL;
+    /*
+     *  calloc hands large blocks out as fresh zero pages,
+     *  so big arrays cost nothing until they are written.
+     */
+    void* data = calloc(array_data_size(type, count) ? array_data_size(type, count) : 1, 1);
+    if (data == NULL)
+        return NULL;
+
+    object_array_t* array = ALLOCATE_OBJECT(object_array_t, OBJ_ARRAY);
+    array->type = type;
+    array->count = count;
+    array->data = data;
+    return array;
+}
+
+int get_array_value(object_array_t* array, uint32_t index, value_t* value) {
+    if (index >= array->count)
+        return -1;
+    switch (array->type) {
+        case ARRAY_INT:
+            *value = INT_VAL(((int64_t*)array->data)[index]);
+            break;
+        case ARRAY_FLOAT:
+            *value = FLOAT_VAL(((double*)array->data)[index]);
+            break;
+        case ARRAY_BYTE:
+            *value = INT_VAL(((uint8_t*)array->data)[index]);
+            break;
+        case ARRAY_BIT:
+            *value = BOOL_VAL((((uint64_t*)array->data)[index >> 6] >> (index & 63)) & 1);
+            break;
+    }
+    return 0;
+}
+
+int set_array_value(object_array_t* array, uint32_t index, value_t value) {
+    if (index >= array->count)
+        return -1;
+    switch (array->type) {
+        case ARRAY_INT:
+            if (!IS_INT(value)) return -2;
+            ((int64_t*)array->data)[index] = AS_INT(value);
+            break;
+        case ARRAY_FLOAT:
+            if (!IS_NUMBER(value)) return -2;
+            ((double*)array->data)[index] = AS_NUMBER(value);
+            break;
+        case ARRAY_BYTE:
+            if (!IS_INT(value) || AS_INT(value) < 0 || AS_INT(value) > UINT8_MAX) return -2;
+            ((uint8_t*)array->data)[index] = (uint8_t)AS_INT(value);
+            break;
+        case ARRAY_BIT: {
+            if (!IS_BOOL(value)) return -2;
+            uint64_t* word = &((uint64_t*)array->data)[index >> 6];
+            uint64_t bit = (uint64_t)1 << (index & 63);
+            *word = AS_BOOL(value) ? (*word | bit) : (*word & ~bit);
+            break;
+        }
+    }
+    return 0;
+}
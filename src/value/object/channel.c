@@ -0,0 +1,106 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "error/error.h"
+#include "utils/mpsc.h"
+#include "value/object/channel.h"
+
+typedef struct {
+    mpsc_node_t node;
+    message_t message;
+} envelope_t;
+
+struct channel {
+    mpsc_queue_t queue;
+    atomic_int refs;
+
+    // set by a receiver about to park, senders only take the lock when it is set
+    atomic_bool waiting;
+    atomic_flag receiving;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+};
+
+channel_t* new_shared_channel() {
+    channel_t* channel = malloc(sizeof(channel_t));
+    if (channel == NULL) {
+        __CLOX_ERROR("Not enough memory to create a channel.");
+    }
+    mpsc_init(&channel->queue);
+    atomic_init(&channel->refs, 1);
+    atomic_init(&channel->waiting, false);
+    atomic_flag_clear(&channel->receiving);
+    pthread_mutex_init(&channel->lock, NULL);
+    pthread_cond_init(&channel->ready, NULL);
+    return channel;
+}
+
+void retain_channel(channel_t* channel) {
+    atomic_fetch_add_explicit(&channel->refs, 1, memory_order_relaxed);
+}
+
+void release_channel(channel_t* channel) {
+    if (atomic_fetch_sub_explicit(&channel->refs, 1, memory_order_acq_rel) != 1)
+        return;
+    // nobody can send anymore, drop what was never received
+    for (mpsc_node_t* node = mpsc_pop(&channel->queue); node; node = mpsc_pop(&channel->queue)) {
+        envelope_t* envelope = (envelope_t*)node;
+        free_message(&envelope->message);
+        free(envelope);
+    }
+    pthread_mutex_destroy(&channel->lock);
+    pthread_cond_destroy(&channel->ready);
+    free(channel);
+}
+
+void channel_send(channel_t* channel, message_t message) {
+    envelope_t* envelope = malloc(sizeof(envelope_t));
+    if (envelope == NULL) {
+        __CLOX_ERROR("Not enough memory to send a message.");
+    }
+    envelope->message = message;
+    mpsc_push(&channel->queue, &envelope->node);
+
+    /*
+     *  The push only releases the node, on its own it may be ordered after the load of 'waiting'.
+     *  With a full fence here and one in the receiver between setting 'waiting' and popping,
+     *  either the receiver sees the message before parking, or this sees it parking.
+     */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&channel->waiting, memory_order_relaxed)) {
+        pthread_mutex_lock(&channel->lock);
+        pthread_cond_signal(&channel->ready);
+        pthread_mutex_unlock(&channel->lock);
+    }
+}
+
+bool channel_receive(channel_t* channel, message_t* message) {
+    if (atomic_flag_test_and_set(&channel->receiving))
+        return false;
+
+    mpsc_node_t* node = mpsc_pop(&channel->queue);
+    if (node == NULL) {
+        pthread_mutex_lock(&channel->lock);
+        atomic_store_explicit(&channel->waiting, true, memory_order_relaxed);
+        // pairs with the fence in channel_send()
+        atomic_thread_fence(memory_order_seq_cst);
+        while ((node = mpsc_pop(&channel->queue)) == NULL)
+            pthread_cond_wait(&channel->ready, &channel->lock);
+        atomic_store(&channel->waiting, false);
+        pthread_mutex_unlock(&channel->lock);
+    }
+
+    envelope_t* envelope = (envelope_t*)node;
+    *message = envelope->message;
+    free(envelope);
+    atomic_flag_clear(&channel->receiving);
+    return true;
+}
+
+object_channel_t* new_channel(channel_t* channel) {
+    object_channel_t* object = ALLOCATE_OBJECT(object_channel_t, OBJ_CHANNEL);
+    retain_channel(channel);
+    object->channel = channel;
+    return object;
+}
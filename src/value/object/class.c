@@ -2,22 +2,73 @@
 // Created by shenshuhan on 1/25/24.
 //
 
+#include "basic/memory.h"
+#include "component/valuetable.h"
 #include "value/object/class.h"
+#include "vm/vm.h"
 
 object_class_t* new_class(object_string_t* name) {
     object_class_t* klass = ALLOCATE_OBJECT(object_class_t, OBJ_CLASS);
     klass->name = name;
     init_table(&klass->methods);
+    klass->vtable = NULL;
+    klass->method_count = klass->method_capacity = 0;
+    klass->initializer = NULL;
+    klass->field_count = 0;
     return klass;
 }
 
+void class_define_method(object_class_t* klass, object_string_t* name, object_closure_t* method) {
+    if (name == vm->init_string)
+        klass->initializer = method;
+
+    int slot = class_find_method(klass, name);
+    if (slot >= 0) {
+        klass->vtable[slot].method = method;
+        return;
+    }
+
+    if (klass->method_count == klass->method_capacity) {
+        int old_capacity = klass->method_capacity;
+        klass->method_capacity = GROW_CAPACITY(old_capacity);
+        klass->vtable = GROW_ARRAY(method_slot_t, klass->vtable, old_capacity, klass->method_capacity);
+    }
+    slot = klass->method_count++;
+    klass->vtable[slot] = (method_slot_t){ name, method };
+    table_set_value(&klass->methods, name, INT_VAL(slot));
+}
+
+void class_inherit(object_class_t* klass, object_class_t* superclass) {
+    for (int i = 0; i < superclass->method_count; i++)
+        class_define_method(klass, superclass->vtable[i].name, superclass->vtable[i].method);
+}
+
+int class_find_method(object_class_t* klass, object_string_t* name) {
+    value_t slot;
+    if (!table_get_value(&klass->methods, name, &slot))
+        return -1;
+    return (int)AS_INT(slot);
+}
+
 object_instance_t* new_instance(object_class_t* klass) {
     object_instance_t* instance = ALLOCATE_OBJECT(object_instance_t, OBJ_INSTANCE);
     instance->klass = klass;
     init_table(&instance->fields);
+    if (klass->field_count > 0)
+        table_reserve(&instance->fields, klass->field_count);
     return instance;
 }
 
+void instance_set_field(object_instance_t* instance, object_string_t* name, value_t value) {
+    name->field_name = true;
+    if (!table_set_value(&instance->fields, name, value))
+        return;
+    // a new field, the next instances of the class reserve room for it
+    object_class_t* klass = instance->klass;
+    if (instance->fields.count > klass->field_count && instance->fields.count <= FIELDS_RESERVE_MAX)
+        klass->field_count = instance->fields.count;
+}
+
 object_bound_method_t* new_bound_method(value_t receiver, object_closure_t *method) {
     object_bound_method_t *bound = ALLOCATE_OBJECT(object_bound_method_t, OBJ_BOUND_METHOD);
     bound->receiver = receiver;
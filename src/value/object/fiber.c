@@ -0,0 +1,83 @@
+#include "basic/memory.h"
+#include "value/object/fiber.h"
+
+void init_call_stack(call_stack_t* stack) {
+    stack->frames = ALLOCATE(callframe_t, FRAMES_INITIAL);
+    stack->stack = ALLOCATE(value_t, STACK_INITIAL);
+    if (stack->frames == NULL || stack->stack == NULL) {
+        __CLOX_ERROR("Not enough memory to create a call stack.");
+    }
+    stack->frame_capacity = FRAMES_INITIAL;
+    stack->stack_capacity = STACK_INITIAL;
+    stack->frame_count = 0;
+    stack->frame_base = 0;
+    stack->stack_top = stack->stack;
+    list_init(&stack->open_upvalues);
+}
+
+void free_call_stack(call_stack_t* stack) {
+    free(stack->frames);
+    free(stack->stack);
+    stack->frames = NULL;
+    stack->stack = stack->stack_top = NULL;
+    stack->frame_count = stack->frame_capacity = stack->stack_capacity = 0;
+}
+
+void grow_call_stack(call_stack_t* stack, int slots) {
+    if (stack->frame_count == stack->frame_capacity) {
+        stack->frame_capacity *= 2;
+        stack->frames = realloc(stack->frames, sizeof(callframe_t) * stack->frame_capacity);
+        if (stack->frames == NULL) {
+            __CLOX_ERROR("Not enough memory to grow a call stack.");
+        }
+    }
+
+    int used = (int)(stack->stack_top - stack->stack);
+    if (used + slots <= stack->stack_capacity)
+        return;
+    int capacity = stack->stack_capacity;
+    while (used + slots > capacity)
+        capacity *= 2;
+    value_t* values = realloc(stack->stack, sizeof(value_t) * capacity);
+    if (values == NULL) {
+        __CLOX_ERROR("Not enough memory to grow a call stack.");
+    }
+
+    // everything pointing into the old stack keeps its offset
+    for (int i = 0; i < stack->frame_count; i++)
+        stack->frames[i].slots = values + (stack->frames[i].slots - stack->stack);
+    object_upvalue_t* iter = NULL;
+    list_iterate_begin(object_upvalue_t, link, &stack->open_upvalues, iter) {
+        iter->location = values + (iter->location - stack->stack);
+    } list_iterate_end();
+
+    stack->stack_top = values + used;
+    stack->stack = values;
+    stack->stack_capacity = capacity;
+}
+
+void mark_call_stack(call_stack_t* stack) {
+    for (value_t* slot = stack->stack; slot < stack->stack_top; slot++)
+        mark_value(*slot);
+    for (int i = 0; i < stack->frame_count; i++)
+        mark_object((object_t*)stack->frames[i].closure);
+    object_upvalue_t* iter = NULL;
+    list_iterate_begin(object_upvalue_t, link, &stack->open_upvalues, iter) {
+        mark_object((object_t*)iter);
+    } list_iterate_end();
+}
+
+object_fiber_t* new_fiber(object_closure_t* closure) {
+    object_fiber_t* fiber = ALLOCATE_OBJECT(object_fiber_t, OBJ_FIBER);
+    fiber->closure = closure;
+    fiber->state = FIBER_NEW;
+    fiber->task = false;
+    fiber->caller = NULL;
+    // the stack is only allocated once the fiber starts
+    fiber->stack.frames = NULL;
+    fiber->stack.frame_count = fiber->stack.frame_capacity = fiber->stack.stack_capacity = 0;
+    fiber->stack.frame_base = 0;
+    fiber->stack.stack = fiber->stack.stack_top = NULL;
+    list_init(&fiber->stack.open_upvalues);
+    return fiber;
+}
@@ -5,8 +5,10 @@
 object_function_t* new_function() {
     object_function_t* function = ALLOCATE_OBJECT(object_function_t, OBJ_FUNCTION);
     function->arity = 0;
+    function->max_slots = 0;
     function->upvalue_count = 0;
     function->name = NULL;
+    function->module = NULL;
     init_chunk(&function->chunk);
     return function;
 }
@@ -19,9 +21,12 @@ object_native_func_t* new_native(int argc, native_fn_t func) {
 }
 
 object_closure_t* new_closure(object_function_t* function) {
-    object_upvalue_t** upvalues = ALLOCATE(object_upvalue_t*, function->upvalue_count);
-    for (int i = 0; i < function->upvalue_count; ++i) {
-        upvalues[i] = NULL;
+    object_upvalue_t** upvalues = NULL;
+    if (function->upvalue_count) {
+        upvalues = ALLOCATE(object_upvalue_t*, function->upvalue_count);
+        for (int i = 0; i < function->upvalue_count; ++i) {
+            upvalues[i] = NULL;
+        }
     }
 
     object_closure_t* closure = ALLOCATE_OBJECT(object_closure_t, OBJ_CLOSURE);
@@ -35,6 +40,7 @@ object_upvalue_t* new_upvalue(value_t* slot) {
     object_upvalue_t* upvalue = ALLOCATE_OBJECT(object_upvalue_t, OBJ_UPVALUE);
     upvalue->location = slot;
     upvalue->closed = NIL_VAL;
+    upvalue->fiber = NULL;
     list_link_init(&upvalue->link);
     return upvalue;
 }
\ No newline at end of file
@@ -1,28 +1,132 @@
 //
 // Created by shenshuhan on 1/28/24.
 //
+#define _DEFAULT_SOURCE
+
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "constant.h"
 
 #include "value/object/list.h"
 #include "value/object.h"
 
+static size_t page_size() {
+    static size_t size = 0;
+    if (!size)
+        size = (size_t)sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+#define VALUES_PER_PAGE (page_size() / sizeof(value_t))
+
+static bool is_page_touched(object_list_t* list, size_t page) {
+    return list->touched[page >> 3] & (1 << (page & 7));
+}
+
+static void touch_list_range(object_list_t* list, size_t from, size_t to) {
+    if (list->touched == NULL || from >= to)
+        return;
+    for (size_t page = from / VALUES_PER_PAGE; page <= (to - 1) / VALUES_PER_PAGE; page++)
+        list->touched[page >> 3] |= (1 << (page & 7));
+}
+
+/*
+ *  Maps zero-filled storage for 'capacity' values.
+ *  Returns false if the storage stays on the heap, either because the list is small
+ *  or because the mapping failed, the list is left untouched then.
+ */
+static bool map_list_storage(object_list_t* list, size_t capacity) {
+    size_t bytes = capacity * sizeof(value_t);
+    if (bytes < LIST_LAZY_THRESHOLD)
+        return false;
+
+    size_t mapped_size = (bytes + page_size() - 1) & ~(page_size() - 1);
+    void* storage = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (storage == MAP_FAILED)
+        return false;
+
+    size_t pages = mapped_size / page_size();
+    uint8_t* touched = (uint8_t*)calloc((pages + 7) >> 3, sizeof(uint8_t));
+    if (touched == NULL) {
+        munmap(storage, mapped_size);
+        return false;
+    }
+    list->touched = touched;
+    list->list = (value_t*)storage;
+    list->mapped_size = mapped_size;
+    return true;
+}
+
 object_list_t* new_list(uint32_t capacity, value_t value) {
     if (capacity > LIST_CAPACITY_MAX)
         return NULL;
 
     object_list_t *list = ALLOCATE_OBJECT(object_list_t, OBJ_LIST);
+    list->count = capacity;
     list->capacity = capacity;
     list->initial = value;
-    value_t* value_list = ALLOCATE(value_t, list->capacity);
-    memset(value_list, 0, list->capacity * sizeof(value_t));
-    list->list = value_list;
+    list->touched = NULL;
+    list->mapped_size = 0;
+    if (!map_list_storage(list, capacity)) {
+        value_t* value_list = ALLOCATE(value_t, list->capacity);
+        memset(value_list, 0, list->capacity * sizeof(value_t));
+        list->list = value_list;
+    }
     return list;
 }
 
+static int grow_list(object_list_t* list) {
+    if (list->capacity >= LIST_CAPACITY_MAX)
+        return -1;
+    int old_capacity = list->capacity;
+    int capacity = GROW_CAPACITY(old_capacity);
+    if (capacity > LIST_CAPACITY_MAX)
+        capacity = LIST_CAPACITY_MAX;
+
+    if ((size_t)capacity * sizeof(value_t) < LIST_LAZY_THRESHOLD) {
+        list->list = GROW_ARRAY(value_t, list->list, old_capacity, capacity);
+        list->capacity = capacity;
+        return 0;
+    }
+
+    value_t* old_list = list->list;
+    uint8_t* old_touched = list->touched;
+    size_t old_mapped_size = list->mapped_size;
+    if (!map_list_storage(list, capacity)) {
+        // mapped storage cannot be reallocated, the list stays as it is
+        if (old_touched != NULL)
+            return -1;
+        list->list = GROW_ARRAY(value_t, old_list, old_capacity, capacity);
+        list->capacity = capacity;
+        return 0;
+    }
+    list->capacity = capacity;
+
+    if (old_touched == NULL) {
+        memcpy(list->list, old_list, list->count * sizeof(value_t));
+        touch_list_range(list, 0, list->count);
+        FREE_ARRAY(value_t, old_list, old_capacity);
+        return 0;
+    }
+
+    /*  only pages ever written hold anything but zeros  */
+    size_t old_pages = old_mapped_size / page_size();
+    memcpy(list->touched, old_touched, (old_pages + 7) >> 3);
+    for (size_t page = 0; page < old_pages; page++) {
+        if (old_touched[page >> 3] & (1 << (page & 7)))
+            memcpy((char*)list->list + page * page_size(),
+                   (char*)old_list + page * page_size(), page_size());
+    }
+    munmap(old_list, old_mapped_size);
+    free(old_touched);
+    return 0;
+}
+
 int get_list_value(object_list_t* list, uint32_t index, value_t* value) {
-    if (index >= list->capacity) {
+    if (index >= list->count) {
         /*
          *  out-of-bound
          */
@@ -34,9 +138,70 @@ int get_list_value(object_list_t* list, uint32_t index, value_t* value) {
 }
 
 int set_list_value(object_list_t* list, uint32_t index, value_t value) {
-    if (index >= list->capacity) {
+    if (index >= list->count) {
         return -1;
     }
+    touch_list_range(list, index, index + 1);
     list->list[index] = value;
     return 0;
-}
\ No newline at end of file
+}
+
+int append_list_value(object_list_t* list, value_t value) {
+    if (list->count == list->capacity && grow_list(list))
+        return -1;
+    touch_list_range(list, list->count, list->count + 1);
+    list->list[list->count++] = value;
+    return 0;
+}
+
+int insert_list_value(object_list_t* list, uint32_t index, value_t value) {
+    if (index > list->count) {
+        return -1;
+    }
+    if (list->count == list->capacity && grow_list(list))
+        return -1;
+    touch_list_range(list, index, list->count + 1);
+    memmove(&list->list[index + 1], &list->list[index],
+            (list->count - index) * sizeof(value_t));
+    list->list[index] = value;
+    list->count++;
+    return 0;
+}
+
+int pop_list_value(object_list_t* list, value_t* value) {
+    if (list->count == 0) {
+        return -1;
+    }
+    get_list_value(list, list->count - 1, value);
+    list->count--;
+    return 0;
+}
+
+void mark_list_values(object_list_t* list) {
+    mark_value(list->initial);
+    if (list->touched == NULL) {
+        for (int i = 0; i < list->count; i++)
+            mark_value(list->list[i]);
+        return;
+    }
+
+    /*  untouched pages only hold the 'initial' sentinel, no need to scan them  */
+    size_t per_page = VALUES_PER_PAGE;
+    for (size_t start = 0; start < list->count; start += per_page) {
+        if (!is_page_touched(list, start / per_page))
+            continue;
+        size_t end = start + per_page < list->count ? start + per_page : list->count;
+        for (size_t i = start; i < end; i++)
+            mark_value(list->list[i]);
+    }
+}
+
+void free_list_storage(object_list_t* list) {
+    if (list->touched == NULL) {
+        FREE_ARRAY(value_t, list->list, list->capacity);
+        return;
+    }
+    munmap(list->list, list->mapped_size);
+    free(list->touched);
+    list->touched = NULL;
+}
@@ -0,0 +1,274 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "error/error.h"
+#include "basic/memory.h"
+#include "value/object/map.h"
+#include "value/object/rope.h"
+#include "value/object/string.h"
+
+/*
+ *  0b0hhhhhhh -> a full slot, 'h' are the low 7 bits of its key's hash
+ *  EMPTY      -> never filled since the table was last rebuilt, a lookup reaching a group with one stops there
+ *  DELETED    -> emptied in a group that was full, lookups go on past it
+ */
+#define CONTROL_EMPTY   0x80
+#define CONTROL_DELETED 0xfe
+
+#if defined(__GNUC__)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+typedef uint8_t group_u8_t __attribute__((vector_size(MAP_GROUP_WIDTH)));
+typedef int8_t  group_s8_t __attribute__((vector_size(MAP_GROUP_WIDTH)));
+
+//  one bit per control byte, taken from the byte's top bit
+static inline uint32_t group_mask(group_s8_t bytes) {
+#if defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8((__m128i)bytes);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < MAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t)((uint8_t)bytes[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+// the slots of the group at 'control' holding 'byte'
+static inline uint32_t match_byte(const uint8_t* control, uint8_t byte) {
+    group_u8_t group = *(const group_u8_t*)control;
+    return group_mask((group_s8_t)(group == byte));
+}
+
+// the slots of the group at 'control' without an entry
+static inline uint32_t match_free(const uint8_t* control) {
+    return group_mask(*(const group_s8_t*)control);
+}
+
+#define FIRST_SLOT(mask) __builtin_ctz(mask)
+#else
+static inline uint32_t match_byte(const uint8_t* control, uint8_t byte) {
+    uint32_t mask = 0;
+    for (int i = 0; i < MAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(control[i] == byte) << i;
+    return mask;
+}
+
+static inline uint32_t match_free(const uint8_t* control) {
+    uint32_t mask = 0;
+    for (int i = 0; i < MAP_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(control[i] >> 7) << i;
+    return mask;
+}
+
+static inline int FIRST_SLOT(uint32_t mask) {
+    int slot = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        slot++;
+    }
+    return slot;
+}
+#endif
+
+static uint64_t hash_key(value_t key) {
+    uint64_t bits;
+    switch (key.type) {
+        case VAL_INT:   bits = (uint64_t)AS_INT(key); break;
+        case VAL_FLOAT: memcpy(&bits, &key.as.number, sizeof(bits)); break;
+        case VAL_BOOL:  bits = AS_BOOL(key); break;
+        default:        bits = string_hash((object_string_t*)AS_OBJECT(key)); break;
+    }
+    // keys of different types with the same bits land apart, the rest spreads the bits over the word
+    bits += (uint64_t)key.type * 0x9e3779b97f4a7c15ULL;
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    bits *= 0xc4ceb9fe1a85ec53ULL;
+    bits ^= bits >> 33;
+    return bits;
+}
+
+static inline uint8_t hash_control(uint64_t hash) {
+    return hash & 0x7f;
+}
+
+static inline bool keys_equal(value_t a, value_t b) {
+    if (a.type != b.type)
+        return false;
+    switch (a.type) {
+        case VAL_INT:   return AS_INT(a) == AS_INT(b);
+        case VAL_FLOAT: return AS_FLOAT(a) == AS_FLOAT(b);
+        case VAL_BOOL:  return AS_BOOL(a) == AS_BOOL(b);
+        default:        return strings_equal((object_string_t*)AS_OBJECT(a), (object_string_t*)AS_OBJECT(b));
+    }
+}
+
+/*
+ * Groups are probed at triangular offsets from the one picked by the hash,
+ * with a power of two groups that visits every group once.
+ */
+#define PROBE_BEGIN(map, hash, group, mask) \
+    size_t mask = (size_t)(map)->capacity / MAP_GROUP_WIDTH - 1; \
+    size_t group = ((hash) >> 7) & mask; \
+    for (size_t step = 1;; group = (group + step++) & mask)
+
+static int find_slot(object_map_t* map, value_t key, uint64_t hash) {
+    if (map->capacity == 0)
+        return -1;
+    uint8_t byte = hash_control(hash);
+    PROBE_BEGIN(map, hash, group, mask) {
+        const uint8_t* control = map->control + group * MAP_GROUP_WIDTH;
+        for (uint32_t match = match_byte(control, byte); match; match &= match - 1) {
+            int slot = (int)group * MAP_GROUP_WIDTH + FIRST_SLOT(match);
+            if (keys_equal(map->entries[slot].key, key))
+                return slot;
+        }
+        if (match_byte(control, CONTROL_EMPTY))
+            return -1;
+    }
+}
+
+// the first empty or deleted slot on the key's probe sequence
+static int find_free_slot(object_map_t* map, uint64_t hash) {
+    PROBE_BEGIN(map, hash, group, mask) {
+        uint32_t free_slots = match_free(map->control + group * MAP_GROUP_WIDTH);
+        if (free_slots)
+            return (int)group * MAP_GROUP_WIDTH + FIRST_SLOT(free_slots);
+    }
+}
+
+static inline int max_entries(int capacity) {
+    return capacity - capacity / 8;
+}
+
+static void resize(object_map_t* map, int capacity) {
+    uint8_t* control = map->control;
+    map_entry_t* entries = map->entries;
+    int old_capacity = map->capacity;
+
+    // groups are loaded as aligned vectors
+    map->control = aligned_alloc(MAP_GROUP_WIDTH, capacity);
+    map->entries = ALLOCATE(map_entry_t, capacity);
+    if (map->control == NULL || map->entries == NULL) {
+        __CLOX_ERROR("Not enough memory to grow a map.");
+    }
+    memset(map->control, CONTROL_EMPTY, capacity);
+    map->capacity = capacity;
+    map->growth_left = max_entries(capacity) - map->count;
+
+    for (int i = 0; i < old_capacity; i++) {
+        if (control[i] >= 0x80)
+            continue;
+        uint64_t hash = hash_key(entries[i].key);
+        int slot = find_free_slot(map, hash);
+        map->control[slot] = hash_control(hash);
+        map->entries[slot] = entries[i];
+    }
+    free(control);
+    free(entries);
+}
+
+object_map_t* new_map(int count) {
+    object_map_t* map = ALLOCATE_OBJECT(object_map_t, OBJ_MAP);
+    map->count = map->growth_left = map->capacity = 0;
+    map->control = NULL;
+    map->entries = NULL;
+    if (count > 0) {
+        int capacity = MAP_GROUP_WIDTH;
+        while (max_entries(capacity) < count)
+            capacity *= 2;
+        resize(map, capacity);
+    }
+    return map;
+}
+
+bool map_key(value_t value, value_t* key) {
+    switch (value.type) {
+        case VAL_INT:
+        case VAL_BOOL:
+            *key = value;
+            return true;
+        case VAL_FLOAT:
+            if (isnan(AS_FLOAT(value)))
+                return false;
+            // -0.0 + 0.0 is 0.0
+            *key = FLOAT_VAL(AS_FLOAT(value) + 0.0);
+            return true;
+        case VAL_OBJ:
+            if (!is_string_like(value))
+                return false;
+            *key = flatten_value(value);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool map_get(object_map_t* map, value_t key, value_t* value) {
+    int slot = find_slot(map, key, hash_key(key));
+    if (slot < 0)
+        return false;
+    *value = map->entries[slot].value;
+    return true;
+}
+
+void map_set(object_map_t* map, value_t key, value_t value) {
+    uint64_t hash = hash_key(key);
+    int slot = find_slot(map, key, hash);
+    if (slot >= 0) {
+        map->entries[slot].value = value;
+        return;
+    }
+
+    if (map->growth_left == 0) {
+        // rebuilding at the same size clears the deleted slots, unless the live entries fill most of it
+        int capacity = map->capacity == 0 ? MAP_GROUP_WIDTH : map->capacity;
+        if (map->count * 32 > capacity * 25)
+            capacity *= 2;
+        resize(map, capacity);
+    }
+    slot = find_free_slot(map, hash);
+    if (map->control[slot] == CONTROL_EMPTY)
+        map->growth_left--;
+    map->control[slot] = hash_control(hash);
+    map->entries[slot] = (map_entry_t){key, value};
+    map->count++;
+}
+
+bool map_remove(object_map_t* map, value_t key) {
+    int slot = find_slot(map, key, hash_key(key));
+    if (slot < 0)
+        return false;
+    /*
+     * A group holding an empty slot has never been full since the table was rebuilt,
+     * so no probe ever went past it and the slot can be empty again.
+     */
+    const uint8_t* group = map->control + (slot & ~(MAP_GROUP_WIDTH - 1));
+    if (match_byte(group, CONTROL_EMPTY)) {
+        map->control[slot] = CONTROL_EMPTY;
+        map->growth_left++;
+    } else {
+        map->control[slot] = CONTROL_DELETED;
+    }
+    map->count--;
+    return true;
+}
+
+void mark_map_entries(object_map_t* map) {
+    for (int i = 0; i < map->capacity; i++) {
+        if (!map_slot_full(map, i))
+            continue;
+        mark_value(map->entries[i].key);
+        mark_value(map->entries[i].value);
+    }
+}
+
+void free_map_storage(object_map_t* map) {
+    free(map->control);
+    free(map->entries);
+    map->control = NULL;
+    map->entries = NULL;
+    map->count = map->growth_left = map->capacity = 0;
+}
@@ -0,0 +1,58 @@
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "value/object/module.h"
+
+object_module_t* new_module(object_string_t* path) {
+    object_module_t* module = ALLOCATE_OBJECT(object_module_t, OBJ_MODULE);
+    module->path = path;
+    module->loaded = false;
+    module->shadowed_intrinsics = 0;
+    init_table(&module->globals);
+    return module;
+}
+
+object_string_t* resolve_module_path(object_module_t* importer, object_string_t* name) {
+    char joined[PATH_MAX];
+    int directory = 0;
+    if (name->chars[0] != '/' && importer->path != NULL) {
+        const char* slash = strrchr(importer->path->chars, '/');
+        if (slash != NULL)
+            directory = (int)(slash - importer->path->chars) + 1;
+    }
+    if (directory + name->length >= PATH_MAX)
+        return NULL;
+    memcpy(joined, importer->path ? importer->path->chars : "", directory);
+    memcpy(joined + directory, name->chars, name->length + 1);
+
+    // the canonical path makes "a/../b.lox" and "b.lox" the same cache entry
+    char canonical[PATH_MAX];
+    if (realpath(joined, canonical) == NULL)
+        return NULL;
+    return copy_string(canonical, (int)strlen(canonical));
+}
+
+char* read_module_source(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return NULL;
+
+    fseek(file, 0L, SEEK_END);
+    long file_size = ftell(file);
+    rewind(file);
+
+    char* buffer = file_size < 0 ? NULL : malloc(file_size + 1);
+    if (buffer == NULL || fread(buffer, sizeof(char), file_size, file) < (size_t)file_size) {
+        free(buffer);
+        fclose(file);
+        return NULL;
+    }
+    buffer[file_size] = '\0';
+
+    fclose(file);
+    return buffer;
+}
@@ -0,0 +1,79 @@
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "constant.h"
+
+#include "basic/memory.h"
+#include "value/object/reader.h"
+
+object_reader_t* new_reader(int fd) {
+    object_reader_t* reader = ALLOCATE_OBJECT(object_reader_t, OBJ_READER);
+    reader->buffer = ALLOCATE(char, READER_BUFFER_SIZE);
+    if (reader->buffer == NULL) {
+        __CLOX_ERROR("Not enough memory to create a reader.");
+    }
+    reader->fd = fd;
+    reader->capacity = READER_BUFFER_SIZE;
+    reader->start = reader->end = 0;
+    return reader;
+}
+
+// reads more of the file after the unread bytes, false at the end of the file
+static bool fill_buffer(object_reader_t* reader) {
+    if (reader->fd < 0)
+        return false;
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end == reader->capacity) {
+        char* buffer = realloc(reader->buffer, reader->capacity * 2);
+        if (buffer == NULL) {
+            __CLOX_ERROR("Not enough memory to read a line.");
+        }
+        reader->buffer = buffer;
+        reader->capacity *= 2;
+    }
+
+    ssize_t count;
+    do {
+        count = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        close_reader(reader);
+        return false;
+    }
+    reader->end += (int)count;
+    return true;
+}
+
+object_string_t* reader_next_line(object_reader_t* reader) {
+    // bytes already searched are not searched again after the buffer is refilled
+    int searched = 0;
+    for (;;) {
+        char* from = reader->buffer + reader->start;
+        char* newline = memchr(from + searched, '\n', reader->end - reader->start - searched);
+        if (newline != NULL) {
+            reader->start += (int)(newline - from) + 1;
+            return copy_uninterned_string(from, (int)(newline - from));
+        }
+        searched = reader->end - reader->start;
+        if (!fill_buffer(reader))
+            break;
+    }
+
+    // the last line may not end with a newline
+    if (reader->start == reader->end)
+        return NULL;
+    object_string_t* line = copy_uninterned_string(reader->buffer + reader->start, reader->end - reader->start);
+    reader->start = reader->end;
+    return line;
+}
+
+void close_reader(object_reader_t* reader) {
+    if (reader->fd >= 0)
+        close(reader->fd);
+    reader->fd = -1;
+}
@@ -0,0 +1,73 @@
+#include <string.h>
+
+#include "constant.h"
+#include "common.h"
+
+#include "utils/stack.h"
+#include "value/object/rope.h"
+
+int string_like_length(value_t value) {
+    return IS_ROPE(value) ? AS_ROPE(value)->length : AS_STRING(value)->length;
+}
+
+value_t concatenate(value_t lhs, value_t rhs) {
+    int64_t length = (int64_t)string_like_length(lhs) + string_like_length(rhs);
+    if (length > STRING_LENGTH_MAX)
+        return NONE_VAL;
+    if (IS_STRING(lhs) && IS_STRING(rhs) && length < ROPE_MIN_LENGTH) {
+        object_string_t* a = AS_STRING(lhs);
+        object_string_t* b = AS_STRING(rhs);
+        return OBJECT_VAL(concatenate_string(a->chars, a->length, b->chars, b->length));
+    }
+
+    object_rope_t* rope = ALLOCATE_OBJECT(object_rope_t, OBJ_ROPE);
+    rope->length = (int)length;
+    rope->left = AS_OBJECT(lhs);
+    rope->right = AS_OBJECT(rhs);
+    rope->flat = NULL;
+    return OBJECT_VAL(rope);
+}
+
+object_string_t* flatten_rope(object_rope_t* rope) {
+    if (rope->flat != NULL)
+        return rope->flat;
+
+    /*
+     * Fill the buffer back to front, pushing left before right so the right side pops first.
+     * Left leaning ropes, the shape built by 's = s + x' in a loop, keep the stack at two entries.
+     */
+    char* chars = ALLOCATE(char, rope->length + 1);
+    chars[rope->length] = 0;
+    int position = rope->length;
+
+    clox_stack_t pending;
+    init_stack(&pending);
+    push_stack(&pending, rope);
+    while (pending.count) {
+        object_t* node = pop_stack(&pending);
+        object_string_t* string = NULL;
+        if (node->type == OBJ_STRING) {
+            string = (object_string_t*)node;
+        } else if (((object_rope_t*)node)->flat != NULL) {
+            string = ((object_rope_t*)node)->flat;
+        } else {
+            push_stack(&pending, ((object_rope_t*)node)->left);
+            push_stack(&pending, ((object_rope_t*)node)->right);
+            continue;
+        }
+        position -= string->length;
+        memcpy(chars + position, string->chars, string->length);
+    }
+    free_stack(&pending);
+
+    rope->flat = take_data_string(chars, rope->length);
+    rope->left = NULL;
+    rope->right = NULL;
+    return rope->flat;
+}
+
+value_t flatten_value(value_t value) {
+    if (IS_ROPE(value))
+        return OBJECT_VAL(flatten_rope(AS_ROPE(value)));
+    return value;
+}
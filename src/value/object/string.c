@@ -1,8 +1,13 @@
+#define _GNU_SOURCE
+
 #include <string.h>
+#include <sys/mman.h>
 
 #include "common.h"
+#include "constant.h"
 
 #include "basic/memory.h"
+#include "utils/hash.h"
 #include "vm/vm.h"
 
 #include "value/value.h"
@@ -11,50 +16,91 @@
 
 #include "component/valuetable.h"
 
-static uint32_t hash_string(const char* key, int length) {
-    uint32_t hash = 216613626u;
-    for (int i = 0; i < length; i ++) {
-        hash ^= (uint8_t)key[i];
-        hash *= 16777619;
-    }
-    return hash;
-}
-
-static object_string_t* allocate_string(char* chars, int length, uint32_t hash) {
+static object_string_t* allocate_string(char* chars, int length) {
     object_string_t* string = ALLOCATE_OBJECT(object_string_t, OBJ_STRING);
     string->chars = chars;
     string->length = length;
+    string->hash = 0;
+    string->field_name = false;
+    string->mapped = false;
+    string->interned = false;
+    string->hashed = false;
+    return string;
+}
+
+static object_string_t* intern_string(char* chars, int length, uint32_t hash) {
+    object_string_t* string = allocate_string(chars, length);
     string->hash = hash;
-    table_set_value(&vm.strings, string, NIL_VAL);
+    string->hashed = true;
+    string->interned = true;
+    table_set_value(&vm->strings, string, NIL_VAL);
     return string;
 }
 
 object_string_t* copy_string(const char* chars, int length) {
-    uint32_t hash = hash_string(chars, length);
+    return copy_string_hashed(chars, length, hash_bytes(chars, length));
+}
 
-    object_string_t* interned = table_find_string(&vm.strings, chars, length, hash);
+object_string_t* copy_string_hashed(const char* chars, int length, uint32_t hash) {
+    object_string_t* interned = table_find_string(&vm->strings, chars, length, hash);
     if (interned != NULL) return interned;
 
     char* heap_chars = ALLOCATE(char, length + 1);
     memcpy(heap_chars, chars, length);
     heap_chars[length] = 0;
-    return allocate_string(heap_chars, length, hash);
+    return intern_string(heap_chars, length, hash);
 }
 
 object_string_t* take_string(char* chars, int length) {
-    uint32_t hash = hash_string(chars, length);
+    uint32_t hash = hash_bytes(chars, length);
 
-    object_string_t* interned = table_find_string(&vm.strings, chars, length, hash);
+    object_string_t* interned = table_find_string(&vm->strings, chars, length, hash);
     if (interned != NULL) {
         FREE_ARRAY(char, chars, length + 1);
         return interned;
     }
 
-    return allocate_string(chars, length, hash);
+    return intern_string(chars, length, hash);
+}
+
+object_string_t* copy_data_string(const char* chars, int length) {
+    if (length <= STRING_INTERN_MAX)
+        return copy_string(chars, length);
+    return copy_uninterned_string(chars, length);
+}
+
+object_string_t* take_data_string(char* chars, int length) {
+    if (length <= STRING_INTERN_MAX)
+        return take_string(chars, length);
+    return allocate_string(chars, length);
+}
+
+object_string_t* copy_uninterned_string(const char* chars, int length) {
+    char* heap_chars = ALLOCATE(char, length + 1);
+    memcpy(heap_chars, chars, length);
+    heap_chars[length] = 0;
+    return allocate_string(heap_chars, length);
+}
+
+object_string_t* map_string(int fd, int length) {
+    if (length == 0)
+        return copy_string("", 0);
+    // the mapping reserves one byte past the end of the file, it reads as zero and terminates the chars
+    char* chars = mmap(NULL, length + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (chars == MAP_FAILED)
+        return NULL;
+    if (mmap(chars, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(chars, length + 1);
+        return NULL;
+    }
+
+    object_string_t* string = allocate_string(chars, length);
+    string->mapped = true;
+    return string;
 }
 
 object_string_t* concatenate_string(const char* chars, int len, const char* rhs, int r_len) {
-    char* nchars = ALLOCATE(char, len + r_len);
+    char* nchars = ALLOCATE(char, len + r_len + 1);
     memcpy(nchars, chars, len);
     memcpy(nchars + len, rhs, r_len);
     nchars[len + r_len] = 0;
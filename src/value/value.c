@@ -6,6 +6,7 @@
 
 #include "value/value.h"
 #include "value/object.h"
+#include "value/object/rope.h"
 
 bool IS_NUMBER(value_t value) {
     return IS_FLOAT(value) || IS_INT(value);
@@ -35,24 +36,33 @@ void free_value_array(value_array_t* array) {
     init_value_array(array);
 }
 
-int print_value(value_t value) {
+int write_value(output_t* out, value_t value) {
     switch(value.type) {
         case VAL_NONE:
-            return printf("NONE");
+            return output_string(out, "NONE");
         case VAL_BOOL:
-            return printf(AS_BOOL(value) ? "true" : "false");
+            return output_string(out, AS_BOOL(value) ? "true" : "false");
         case VAL_NIL:
-            return printf("nil");
+            return output_string(out, "nil");
         case VAL_FLOAT:
-            return printf("%g", AS_FLOAT(value));
+            return output_float(out, AS_FLOAT(value));
         case VAL_INT:
-            return printf("%lld", AS_INT(value));
+            return output_int(out, AS_INT(value));
         case VAL_OBJ:
-            return print_object(value);
+            return write_object(out, value);
     }
     return 0;
 }
 
+int print_value(value_t value) {
+    char buffer[128];
+    output_t out;
+    init_output(&out, stdout, buffer, sizeof buffer, false);
+    int length = write_value(&out, value);
+    flush_output(&out);
+    return length;
+}
+
 bool values_equal(value_t a, value_t b) {
     if (a.type != b.type) return false;
     switch(a.type) {
@@ -60,7 +70,15 @@ bool values_equal(value_t a, value_t b) {
         case VAL_NIL:     return true;
         case VAL_FLOAT:   return fabs(AS_NUMBER(a) - AS_NUMBER(b)) < __FLOAT_PRECISION;
         case VAL_INT:     return AS_INT(a) == AS_INT(b);
-        case VAL_OBJ:     return AS_OBJECT(a) == AS_OBJECT(b);
+        case VAL_OBJ:
+            if (AS_OBJECT(a) == AS_OBJECT(b))
+                return true;
+            if (!is_string_like(a) || !is_string_like(b))
+                return false;
+            // strings compare by content, ropes are only flattened when the lengths agree
+            if (string_like_length(a) != string_like_length(b))
+                return false;
+            return strings_equal(AS_STRING(flatten_value(a)), AS_STRING(flatten_value(b)));
         default:          return false;
     }
 }
\ No newline at end of file
@@ -4,7 +4,6 @@
 
 #include "common.h"
 #include "constant.h"
-#include "switch.h"
 
 #include "error/error.h"
 
@@ -15,20 +14,30 @@
 #include "value/value.h"
 #include "value/object/string.h"
 #include "value/object/function.h"
+#include "utils/hash.h"
+#include "vm/vm.h"
 
 #ifdef DEBUG_PRINT_CODE
 #include "debug/debug.h"
 #endif
 
 
-parser_t parser;
-compiler_t* current = NULL;
-class_compiler_t *current_class = NULL;
-chunk_t* compiling_chunk;
+/*
+ * A compilation runs start to end on the thread that called compile(),
+ * so the compiler state is per thread rather than per VM.
+ */
+_Thread_local parser_t parser;
+_Thread_local compiler_t* current = NULL;
+_Thread_local class_compiler_t *current_class = NULL;
+_Thread_local chunk_t* compiling_chunk;
+_Thread_local object_module_t* compiling_module;
+// bit i is set when the source may rebind intrinsics[i], calls to it then stay ordinary calls
+_Thread_local uint32_t shadowed_intrinsics;
 
 static void block();
 static void statement();
 static void var_declaration();
+static uint8_t argument_list();
 
 /*
  * return the depth of current scope
@@ -92,6 +101,7 @@ static void synchronize() {
             case TOKEN_WHILE:
             case TOKEN_PRINT:
             case TOKEN_RETURN:
+            case TOKEN_IMPORT:
                 return;
             default:
                 ;
@@ -124,6 +134,7 @@ static token_t synthetic_token(const char* text) {
     token_t token;
     token.start = text;
     token.length = (int)strlen(text);
+    token.hash = hash_bytes(text, token.length);
     return token;
 }
 
@@ -182,21 +193,23 @@ static void init_compiler(compiler_t* compiler, function_type_t type) {
     compiler->local_count = 0;
     compiler->loop_count  = 0;
     compiler->scope_depth = 0;
+    compiler->last_call = -1;
     compiler->function = new_function();
+    compiler->function->module = compiling_module;
     current = compiler;
 
     if (type != TYPE_SCRIPT)
-        current->function->name = copy_string(parser.previous.start, parser.previous.length);
+        current->function->name = copy_string_hashed(parser.previous.start, parser.previous.length,
+                                                     parser.previous.hash);
 
     local_t* local = &current->locals[current->local_count++];
     local->depth = 0;
     local->is_captured = false;
+    local->mutable = false;
     if (type != TYPE_FUNCTION) {
-        local->name.start = "this";
-        local->name.length = 4;
+        local->name = synthetic_token("this");
     } else {
-        local->name.start = "";
-        local->name.length = 0;
+        local->name = synthetic_token("");
     }
 }
 
@@ -214,9 +227,150 @@ static void emit_return() {
     emit_byte(OP_RETURN);
 }
 
+/*
+ * The most values the code keeps on the stack at once, the frame starts with the callee and its arguments.
+ * The compiler only jumps around structured code: a point reached by a forward jump is reached
+ * with the same depth as the code falling into it, and loops jump back to code seen already.
+ */
+static int max_stack_depth(object_function_t* function) {
+    chunk_t* chunk = &function->chunk;
+    int* targets = ALLOCATE(int, chunk->count + 1);
+    for (int i = 0; i <= chunk->count; i++)
+        targets[i] = -1;
+
+    int depth = function->arity + 1;
+    int max = depth;
+    for (int offset = 0; offset < chunk->count;) {
+        // after a jump or a return the depth comes from the jumps landing here
+        if (targets[offset] > depth)
+            depth = targets[offset];
+
+        int length = 1;
+        int effect = 0;
+        switch (chunk->code[offset]) {
+            case OP_NIL:
+            case OP_TRUE:
+            case OP_FALSE:
+                effect = 1; break;
+            case OP_CONSTANT:
+            case OP_GET_LOCAL:
+            case OP_GET_UPVALUE:
+            case OP_GET_GLOBAL:
+            case OP_CLASS:
+                length = 2; effect = 1; break;
+            case OP_CONSTANT_LONG:
+            case OP_GET_GLOBAL_LONG:
+            case OP_CLASS_LONG:
+                length = 3; effect = 1; break;
+            case OP_NEGATE:
+            case OP_NOT:
+            case OP_SQRT:
+            case OP_FLOOR:
+            case OP_ABS:
+            case OP_LEN:
+            case OP_TYPE:
+                break;
+            case OP_SET_LOCAL:
+            case OP_SET_UPVALUE:
+            case OP_SET_GLOBAL:
+            case OP_GET_PROPERTY:
+                length = 2; break;
+            case OP_SET_GLOBAL_LONG:
+            case OP_GET_PROPERTY_LONG:
+                length = 3; break;
+            case OP_ADD:
+            case OP_SUBTRACT:
+            case OP_MULTIPLY:
+            case OP_DIVIDE:
+            case OP_MOD:
+            case OP_FLOOR_DIVIDE:
+            case OP_LEFT_SHIFT:
+            case OP_RIGHT_SHIFT:
+            case OP_BIT_AND:
+            case OP_BIT_OR:
+            case OP_BIT_XOR:
+            case OP_EQUAL:
+            case OP_GREATER:
+            case OP_LESS:
+            case OP_MIN:
+            case OP_MAX:
+            case OP_POW:
+            case OP_GET_ARRAY_INDEX:
+            case OP_ARRAY:
+            case OP_INHERIT:
+            case OP_CLOSURE_UPVALUE:
+            case OP_PRINT:
+            case OP_PRINTLN:
+            case OP_POP:
+            case OP_RESUME:
+            case OP_RETURN:
+                effect = -1; break;
+            case OP_YIELD:
+                break;
+            case OP_SET_ARRAY_INDEX:
+            case OP_IMPORT_BIND:
+                effect = -2; break;
+            case OP_DEFINE_GLOBAL:
+            case OP_DEFINE_MUT_GLOBAL:
+            case OP_SET_PROPERTY:
+            case OP_GET_SUPER:
+            case OP_METHOD:
+                length = 2; effect = -1; break;
+            case OP_DEFINE_GLOBAL_LONG:
+            case OP_DEFINE_MUT_GLOBAL_LONG:
+            case OP_SET_PROPERTY_LONG:
+            case OP_GET_SUPER_LONG:
+            case OP_METHOD_LONG:
+                length = 3; effect = -1; break;
+            case OP_POPN:
+                length = 2; effect = -chunk->code[offset + 1]; break;
+            case OP_CALL:
+            case OP_TAIL_CALL:
+                length = 2; effect = -chunk->code[offset + 1]; break;
+            case OP_INVOKE:
+            case OP_TAIL_INVOKE:
+                length = 4; effect = -chunk->code[offset + 2]; break;
+            case OP_INVOKE_LONG:
+            case OP_TAIL_INVOKE_LONG:
+                length = 5; effect = -chunk->code[offset + 3]; break;
+            case OP_ARRAY_LITERAL:
+                length = 2; effect = 1 - chunk->code[offset + 1]; break;
+            case OP_MAP_LITERAL:
+                length = 2; effect = 1 - 2 * chunk->code[offset + 1]; break;
+            case OP_IMPORT:
+                length = 2; effect = 2; break;
+            case OP_IMPORT_LONG:
+                length = 3; effect = 2; break;
+            case OP_CLOSURE: {
+                object_function_t* closed = AS_FUNCTION(chunk->constants.values[chunk->code[offset + 1]]);
+                length = 2 + 2 * closed->upvalue_count;
+                effect = 1;
+                break;
+            }
+            case OP_JUMP:
+            case OP_JUMP_IF_FALSE: {
+                int target = offset + 3 + ((chunk->code[offset + 1] << 8) | chunk->code[offset + 2]);
+                if (target <= chunk->count && targets[target] < depth)
+                    targets[target] = depth;
+                length = 3;
+                break;
+            }
+            case OP_LOOP:
+                length = 3; break;
+        }
+        depth += effect;
+        if (depth > max)
+            max = depth;
+        offset += length;
+    }
+    FREE_ARRAY(int, targets, chunk->count + 1);
+    return max;
+}
+
 static object_function_t* end_compiler() {
     emit_return();
     object_function_t* func = current->function;
+    func->max_slots = max_stack_depth(func);
 
 #ifdef DEBUG_PRINT_CODE
     if (!parser.had_error) {
@@ -261,8 +415,9 @@ static void mark_variable_inited() {
 
 static void define_variable(uint16_t global, bool mutable) {
     if (current->scope_depth) {
+        // locals live in their stack slot, only the compiler tracks whether they can be assigned
+        current->locals[current->local_count - 1].mutable = mutable;
         mark_variable_inited();
-        emit_byte(mutable ? OP_DEFINE_MUT_LOCAL : OP_DEFINE_LOCAL);
         return;
     }
     if (global > __OP_CONSTANT_LONG_MAX_INDEX) {
@@ -279,11 +434,11 @@ static void define_variable(uint16_t global, bool mutable) {
 }
 
 static uint16_t identifier_constant(token_t *name) {
-    return make_constant(OBJECT_VAL(copy_string(name->start, name->length)));
+    return make_constant(OBJECT_VAL(copy_string_hashed(name->start, name->length, name->hash)));
 }
 
 static bool identifier_equal(token_t* a, token_t* b) {
-    if (a->length != b->length) return false;
+    if (a->length != b->length || a->hash != b->hash) return false;
     return !memcmp(a->start, b->start, a->length);
 }
 
@@ -300,11 +455,11 @@ static int resolve_local(compiler_t* compiler, token_t* name) {
     return -1;
 }
 
-static int add_upvalue(compiler_t* compiler, uint8_t index, bool is_local) {
+static int add_upvalue(compiler_t* compiler, uint8_t index, bool is_local, bool mutable) {
     int upvalue_count = compiler->function->upvalue_count;
 
     for (int i = 0; i < upvalue_count; i++) {
-        upvalue_t* upvalue = &compiler->function->upvalues[i];
+        upvalue_t* upvalue = &compiler->upvalues[i];
         if (upvalue->index == index && upvalue->is_local == is_local) {
             return i;
         }
@@ -316,6 +471,7 @@ static int add_upvalue(compiler_t* compiler, uint8_t index, bool is_local) {
 
     compiler->upvalues[upvalue_count].is_local = is_local;
     compiler->upvalues[upvalue_count].index = index;
+    compiler->upvalues[upvalue_count].mutable = mutable;
     return compiler->function->upvalue_count++;
 }
 
@@ -325,12 +481,12 @@ static int resolve_upvalue(compiler_t* compiler, token_t* name) {
     int local = resolve_local(compiler->enclosing, name);
     if (~local) {
         compiler->enclosing->locals[local].is_captured = true;
-        return add_upvalue(compiler, (uint8_t)local, true);
+        return add_upvalue(compiler, (uint8_t)local, true, compiler->enclosing->locals[local].mutable);
     }
 
     int upvalue = resolve_upvalue(compiler->enclosing, name);
     if (~upvalue) {
-        return add_upvalue(compiler, (uint8_t)upvalue, false);
+        return add_upvalue(compiler, (uint8_t)upvalue, false, compiler->enclosing->upvalues[upvalue].mutable);
     }
 
     return -1;
@@ -344,6 +500,7 @@ static void add_local(token_t name) {
     local->name = name;
     local->depth = -1;
     local->is_captured = false;
+    local->mutable = false;
 }
 
 static void declare_variable() {
@@ -374,10 +531,94 @@ static void expression() {
     parse_precedence(PREC_ASSIGNMENT);
 }
 
+typedef struct {
+    const char* name;
+    int length;
+    int arity;
+    op_code_t op;
+} intrinsic_t;
+
+/*
+ * Calls to these natives compile to an opcode of their own as long as the name still means the native.
+ * They must accept ropes as they are and never park a task, the VM runs them without those checks.
+ * The table follows the order of the opcodes.
+ */
+static const intrinsic_t intrinsics[] = {
+    {"sqrt",  4, 1, OP_SQRT},
+    {"floor", 5, 1, OP_FLOOR},
+    {"abs",   3, 1, OP_ABS},
+    {"min",   3, 2, OP_MIN},
+    {"max",   3, 2, OP_MAX},
+    {"pow",   3, 2, OP_POW},
+    {"len",   3, 1, OP_LEN},
+    {"type",  4, 1, OP_TYPE},
+};
+
+#define INTRINSIC_COUNT ((int)(sizeof(intrinsics) / sizeof(intrinsics[0])))
+
+int find_intrinsic(const char* name, int length) {
+    for (int i = 0; i < INTRINSIC_COUNT; i++) {
+        if (length == intrinsics[i].length && memcmp(name, intrinsics[i].name, length) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const char* intrinsic_name(int intrinsic) {
+    return intrinsics[intrinsic].name;
+}
+
+/*
+ * Globals are bound late, so a declaration anywhere in the source shadows the intrinsic everywhere in it.
+ * An imported module may bind any name, sources that import keep ordinary calls altogether.
+ */
+static void find_shadowed_intrinsics(const char* source) {
+    shadowed_intrinsics = 0;
+    init_scanner(source);
+    tokentype_t previous = TOKEN_EOF;
+    for (token_t token = scan_token(); token.type != TOKEN_EOF; token = scan_token()) {
+        if (token.type == TOKEN_IMPORT) {
+            shadowed_intrinsics = UINT32_MAX;
+            return;
+        }
+        if (token.type == TOKEN_IDENTIFIER &&
+            (previous == TOKEN_VAR || previous == TOKEN_MUT || previous == TOKEN_FUN || previous == TOKEN_CLASS)) {
+            int intrinsic = find_intrinsic(token.start, token.length);
+            if (intrinsic >= 0)
+                shadowed_intrinsics |= 1u << intrinsic;
+        }
+        previous = token.type;
+    }
+}
+
+/*
+ * Compiles the call of the global 'name' to an intrinsic if it is one, the current token is its '('.
+ * Globals the module already has from an earlier compilation shadow intrinsics as well,
+ * the VM checks for ones it defines later.
+ */
+static bool intrinsic_call(token_t* name) {
+    int intrinsic = find_intrinsic(name->start, name->length);
+    uint32_t shadowed = shadowed_intrinsics | compiling_module->shadowed_intrinsics;
+    if (intrinsic < 0 || (shadowed & (1u << intrinsic)))
+        return false;
+
+    consume(TOKEN_LEFT_PAREN, "Expect '(' before arguments.");
+    uint8_t arg_count = argument_list();
+    if (arg_count != intrinsics[intrinsic].arity) {
+        char message[64];
+        snprintf(message, sizeof message, "Expect %d arguments, but found %d.", intrinsics[intrinsic].arity, arg_count);
+        error_at(name, message);
+    }
+    emit_byte(intrinsics[intrinsic].op);
+    return true;
+}
+
 static void named_variable(token_t name, bool can_assign) {
     int arg = resolve_local(current, &name);
     if (arg != -1) {
         if (can_assign && match(TOKEN_EQUAL)) {
+            if (!current->locals[arg].mutable)
+                error_at(&name, "Cannot assign new values to immutable variable.");
             expression();
             emit_byte_2(OP_SET_LOCAL, (uint8_t) arg);
         } else {
@@ -385,11 +626,15 @@ static void named_variable(token_t name, bool can_assign) {
         }
     } else if (~(arg = resolve_upvalue(current, &name))) {
         if (can_assign && match(TOKEN_EQUAL)) {
+            if (!current->upvalues[arg].mutable)
+                error_at(&name, "Cannot assign new values to immutable variable.");
             expression();
             emit_byte_2(OP_SET_UPVALUE, (uint8_t) arg);
         } else {
             emit_byte_2(OP_GET_UPVALUE, (uint8_t) arg);
         }
+    } else if (check(TOKEN_LEFT_PAREN) && intrinsic_call(&name)) {
+        return;
     } else {
         arg = identifier_constant(&name);
         if (can_assign && match(TOKEN_EQUAL)) {
@@ -648,6 +893,25 @@ static void return_statement() {
         }
         expression();
         consume(TOKEN_SEMICOLON, "Expect ';' after return value.");
+        /*
+         * 'return f(...)' and 'return a.f(...)' reuse the frame for f. The OP_RETURN stays behind it, jumps over the call
+         * like in 'return a and f()' land there, and so do calls of natives and classes.
+         */
+        chunk_t* chunk = current_chunk();
+        int at = current->last_call;
+        if (at >= 0) {
+            switch (chunk->code[at]) {
+                case OP_CALL:
+                    if (at == chunk->count - 2) chunk->code[at] = OP_TAIL_CALL;
+                    break;
+                case OP_INVOKE:
+                    if (at == chunk->count - 4) chunk->code[at] = OP_TAIL_INVOKE;
+                    break;
+                case OP_INVOKE_LONG:
+                    if (at == chunk->count - 5) chunk->code[at] = OP_TAIL_INVOKE_LONG;
+                    break;
+            }
+        }
         emit_byte(OP_RETURN);
     }
 }
@@ -655,6 +919,43 @@ static void return_statement() {
 /******************** STATEMENTS   ENDS *********************/
 /******************** DECLARATIONS STARTS *******************/
 
+static void import_statement() {
+    if (current->type != TYPE_SCRIPT || current->scope_depth) {
+        __CLOX_COMPILER_PREVIOUS_ERROR("Can only import at the top level.");
+    }
+    consume(TOKEN_STRING, "Expect module path after 'import'.");
+    uint16_t constant = make_constant(OBJECT_VAL(copy_string_hashed(parser.previous.start + 1,
+                                          parser.previous.length - 2, parser.previous.hash)));
+
+    if (constant <= __OP_CONSTANT_MAX_INDEX) {
+        emit_byte_2(OP_IMPORT, constant & __UINT8_MASK);
+    } else {
+        emit_byte(OP_IMPORT_LONG);
+        uint8_t hi = (constant >> 8) & __UINT8_MASK;
+        uint8_t lo = (constant     ) & __UINT8_MASK;
+        emit_byte_2(hi, lo);
+    }
+    emit_byte(OP_IMPORT_BIND);
+    consume(TOKEN_SEMICOLON, "Expect ';' after module path.");
+}
+
+static void emit_closure(compiler_t* compiler, object_function_t* func) {
+    /*
+     *  A function capturing nothing behaves the same no matter how many closures wrap it,
+     *  so a single closure is created here and loaded as a constant.
+     *  OP_CLOSURE would allocate a new closure every time the declaration is evaluated.
+     */
+    if (func->upvalue_count == 0) {
+        emit_constant(OBJECT_VAL(new_closure(func)));
+        return;
+    }
+
+    emit_byte_2(OP_CLOSURE, make_constant(OBJECT_VAL(func)));
+    for (int i = 0; i < func->upvalue_count; ++i) {
+        emit_byte_2(compiler->upvalues[i].is_local ? 1 : 0, compiler->upvalues[i].index);
+    }
+}
+
 static void function(function_type_t type) {
     compiler_t compiler;
     init_compiler(&compiler, type);
@@ -680,10 +981,7 @@ static void function(function_type_t type) {
     block();
 
     object_function_t* func = end_compiler();
-    emit_byte_2(OP_CLOSURE, make_constant(OBJECT_VAL(func)));
-    for (int i = 0; i < func->upvalue_count; ++i) {
-        emit_byte_2(compiler.upvalues[i].is_local ? 1 : 0, compiler.upvalues[i].index);
-    }
+    emit_closure(&compiler, func);
 }
 
 static void compile_lambda(function_type_t type) {
@@ -715,10 +1013,7 @@ static void compile_lambda(function_type_t type) {
     }
 
     object_function_t* func = end_compiler();
-    emit_byte_2(OP_CLOSURE, make_constant(OBJECT_VAL(func)));
-    for (int i = 0; i < func->upvalue_count; ++i) {
-        emit_byte_2(compiler.upvalues[i].is_local ? 1 : 0, compiler.upvalues[i].index);
-    }
+    emit_closure(&compiler, func);
 }
 
 static void method() {
@@ -899,6 +1194,8 @@ static void statement() {
         continue_statement();
     } else if (match(TOKEN_RETURN)) {
         return_statement();
+    } else if (match(TOKEN_IMPORT)) {
+        import_statement();
     } else {
         expression_statement();
     }
@@ -1022,9 +1319,40 @@ void lambda(bool can_assign) {
     compile_lambda(TYPE_FUNCTION);
 }
 
+void _yield(bool can_assign) {
+    if (current->type == TYPE_SCRIPT) {
+        __CLOX_COMPILER_PREVIOUS_ERROR("Can't yield from top-level code.");
+    }
+    // a bare 'yield' hands nil to the caller
+    if (check(TOKEN_SEMICOLON) || check(TOKEN_RIGHT_PAREN) ||
+        check(TOKEN_RIGHT_SQUARE) || check(TOKEN_COMMA)) {
+        emit_byte(OP_NIL);
+    } else {
+        parse_precedence(PREC_ASSIGNMENT);
+    }
+    emit_byte(OP_YIELD);
+}
+
+void _resume(bool can_assign) {
+    /*
+     *  resume(fiber)         -> the fiber gets nil
+     *  resume(fiber, value)  -> 'value' is the fiber's argument on the first resume,
+     *                           the result of the pending 'yield' afterwards
+     */
+    consume(TOKEN_LEFT_PAREN, "Expect '(' after 'resume'.");
+    expression();
+    if (match(TOKEN_COMMA)) {
+        expression();
+    } else {
+        emit_byte(OP_NIL);
+    }
+    consume(TOKEN_RIGHT_PAREN, "Expect ')' after resume arguments.");
+    emit_byte(OP_RESUME);
+}
+
 void string(bool can_assign) {
-    emit_constant(OBJECT_VAL(copy_string(parser.previous.start + 1,
-                                parser.previous.length - 2)));
+    emit_constant(OBJECT_VAL(copy_string_hashed(parser.previous.start + 1,
+                                parser.previous.length - 2, parser.previous.hash)));
 }
 
 void variable(bool can_assign) {
@@ -1071,6 +1399,7 @@ static uint8_t argument_list() {
 
 void call(bool can_assign) {
     uint8_t arg_count = argument_list();
+    current->last_call = current_chunk()->count;
     emit_byte_2(OP_CALL, arg_count);
 }
 
@@ -1090,6 +1419,7 @@ void dot(bool can_assign) {
         }
     } else if (match(TOKEN_LEFT_PAREN)) {
         uint8_t arg_count = argument_list();
+        current->last_call = current_chunk()->count;
         if (name <= __OP_CONSTANT_MAX_INDEX) {
             emit_byte_2(OP_INVOKE, name & __UINT8_MASK);
         } else {
@@ -1098,7 +1428,7 @@ void dot(bool can_assign) {
             emit_byte(OP_INVOKE_LONG);
             emit_byte_2(hi, lo);
         }
-        emit_byte(arg_count);
+        emit_byte_2(arg_count, INVOKE_NO_HINT);
     } else {
         if (name <= __OP_CONSTANT_MAX_INDEX) {
             emit_byte_2(OP_GET_PROPERTY, name & __UINT8_MASK);
@@ -1112,12 +1442,54 @@ void dot(bool can_assign) {
 }
 
 void list(bool can_assign) {
-    consume(TOKEN_INTEGER, "Expect an integer as the array length.");
-    number(can_assign);
-    consume(TOKEN_SEMICOLON, "Expect ';' between array length and initialization");
+    /*
+     *  [length; init]  -> a list of 'length' elements, each initialized as 'init'
+     *  [a, b, c]       -> a list holding the listed elements
+     */
+    if (match(TOKEN_RIGHT_SQUARE)) {
+        emit_byte_2(OP_ARRAY_LITERAL, 0);
+        return;
+    }
+
     expression();
-    consume(TOKEN_RIGHT_SQUARE, "Expect ']' after '['.");
-    emit_byte(OP_ARRAY);
+    if (match(TOKEN_SEMICOLON)) {
+        expression();
+        consume(TOKEN_RIGHT_SQUARE, "Expect ']' after '['.");
+        emit_byte(OP_ARRAY);
+        return;
+    }
+
+    int count = 1;
+    while (match(TOKEN_COMMA)) {
+        if (check(TOKEN_RIGHT_SQUARE)) break;
+        expression();
+        if (count == UINT8_MAX) {
+            __CLOX_COMPILER_PREVIOUS_ERROR("can't have more than 255 elements in a list literal.");
+        }
+        count++;
+    }
+    consume(TOKEN_RIGHT_SQUARE, "Expect ']' after list elements.");
+    emit_byte_2(OP_ARRAY_LITERAL, count & __UINT8_MASK);
+}
+
+void map(bool can_assign) {
+    /*
+     *  {}              -> an empty map
+     *  {k: v, ...}     -> a map holding the listed entries, keys are expressions
+     */
+    int count = 0;
+    while (!check(TOKEN_RIGHT_BRACE)) {
+        expression();
+        consume(TOKEN_COLON, "Expect ':' after map key.");
+        expression();
+        if (count == UINT8_MAX) {
+            __CLOX_COMPILER_PREVIOUS_ERROR("can't have more than 255 entries in a map literal.");
+        }
+        count++;
+        if (!match(TOKEN_COMMA)) break;
+    }
+    consume(TOKEN_RIGHT_BRACE, "Expect '}' after map entries.");
+    emit_byte_2(OP_MAP_LITERAL, count & __UINT8_MASK);
 }
 
 void _index(bool can_assign) {
@@ -1140,7 +1512,7 @@ void _this(bool can_assign) {
     variable(false);
 }
 
-object_function_t* compile(const char* source) {
+object_function_t* compile(const char* source, object_module_t* module) {
     /*
      *  Collect garbage before compiling, and then
      *  pause garbage collector while the vm is compiling
@@ -1149,10 +1521,16 @@ object_function_t* compile(const char* source) {
      *  being freed
      */
     collect_garbage();
-    bool enclosed_gc_setting = do_garbage_collector;
-    do_garbage_collector = false;
+#ifdef DEBUG_PRINT_CODE
+    // an import compiles while the importer runs, its listing comes after what was printed so far
+    flush_output(&vm->output);
+#endif
+    bool enclosed_gc_setting = vm->do_garbage_collector;
+    vm->do_garbage_collector = false;
 
+    find_shadowed_intrinsics(source);
     init_scanner(source);
+    compiling_module = module;
 
     compiler_t compiler;
     init_compiler(&compiler, TYPE_SCRIPT);
@@ -1170,7 +1548,7 @@ object_function_t* compile(const char* source) {
     object_function_t* func = end_compiler();
     merge_temporary();
 
-    do_garbage_collector = enclosed_gc_setting;
+    vm->do_garbage_collector = enclosed_gc_setting;
     return parser.had_error ? NULL : func;
 }
 
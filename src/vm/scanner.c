@@ -2,8 +2,9 @@
 
 #include "common.h"
 #include "vm/scanner.h"
-#include "utils/trie.h"
-#include "component/keywordtrie.h"
+#include "utils/hash.h"
+#include "utils/simd.h"
+#include "component/keyword.h"
 
 typedef struct {
     const char* start;
@@ -11,9 +12,7 @@ typedef struct {
     int line;
 } scanner_t;
 
-scanner_t scanner;
-
-static keyword_trie_t keyword_trie;
+_Thread_local scanner_t scanner;
 
 static bool is_at_end() {
     return *scanner.current == '\0';
@@ -42,6 +41,7 @@ static token_t make_token(tokentype_t type) {
     token.start = scanner.start;
     token.length = (int)(scanner.current - scanner.start);
     token.line = scanner.line;
+    token.hash = 0;
     return token;
 }
 
@@ -51,6 +51,7 @@ static token_t error_token(const char* message) {
     token.start = message;
     token.length = (int)strlen(message);
     token.line = scanner.line;
+    token.hash = 0;
     return token;
 }
 
@@ -68,37 +69,45 @@ static char peek_next() {
     return scanner.current[1];
 }
 
+/*
+ * Runs of whitespace, identifier characters and digits are scanned byte by byte for up to
+ * SCAN_SHORT_RUN bytes, which covers most of them, longer runs are handed to the block scanner.
+ * Comments and string literals go to the block scanner directly.
+ */
+#define SCAN_SHORT_RUN 8
+
 static void skip_whitespace() {
     for (;;) {
-        char c = peek();
-        switch(c) {
-            case '\n':
-                scanner.line++;
-            case ' ':
-            case '\r':
-            case '\t':
-                advance();
+        for (int i = 0; ; i++) {
+            char c = peek();
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
                 break;
-            case '/':
-                if (peek_next() == '/') {
-                    while (peek() != '\n' && !is_at_end()) advance();
-                    break;
-                } else {
-                    return;
-                }
-            default:
-                return;
+            if (i == SCAN_SHORT_RUN) {
+                scanner.current = simd_skip_whitespace(scanner.current, &scanner.line);
+                break;
+            }
+            if (c == '\n') scanner.line++;
+            advance();
         }
+        if (peek() != '/' || peek_next() != '/')
+            return;
+        // the newline ending the comment is counted by the next whitespace run
+        scanner.current = simd_find_line_end(scanner.current + 2);
     }
 }
 
 static token_t parse_number() {
     bool is_integer = true;
-    while (is_digit(peek())) advance();
+    for (int i = 0; is_digit(peek()); i++) {
+        if (i == SCAN_SHORT_RUN) {
+            scanner.current = simd_skip_digits(scanner.current);
+            break;
+        }
+        advance();
+    }
     if (peek() == '.' && is_digit(peek_next())) {
         is_integer = false;
-        advance();
-        while (is_digit(peek())) advance();
+        scanner.current = simd_skip_digits(scanner.current + 1);
     }
 
     if (is_integer)
@@ -108,75 +117,43 @@ static token_t parse_number() {
 }
 
 static token_t parse_string() {
-    while (peek() != '"' && !is_at_end()) {
-        if (peek() == '\n') scanner.line++;
-        advance();
-    }
+    scanner.current = simd_find_quote(scanner.current, &scanner.line);
 
     if (is_at_end()) return error_token("Unterminated string.");
 
     advance();
-    return make_token(TOKEN_STRING);
+    token_t token = make_token(TOKEN_STRING);
+    // the characters were just read, hash them while they are still in cache
+    token.hash = hash_bytes(token.start + 1, token.length - 2);
+    return token;
 }
 
 static tokentype_t identifier_type() {
-    
-    keyword_trie_node_t* keyword_found;
-    int length = scanner.current - scanner.start;
-    __trie_find_node(keyword_trie_node_t, trie_node, &keyword_trie.trie, scanner.start, length, &keyword_found);
-
-    if (keyword_found != NULL)
-        return keyword_found->tokentype;
-
-    return TOKEN_IDENTIFIER;
+    return keyword_type(scanner.start, (int)(scanner.current - scanner.start));
 }
 
 static token_t parse_identifier() {
-    while (is_alpha(peek()) || is_digit(peek())) advance();
-    return make_token(identifier_type());
-}
-
-static void init_keyword_trie() {
-    keyword_trie_init(&keyword_trie);
-    
-    keyword_trie_insert(&keyword_trie, "and",      TOKEN_AND);
-    keyword_trie_insert(&keyword_trie, "class",    TOKEN_CLASS);
-    keyword_trie_insert(&keyword_trie, "this",     TOKEN_THIS);
-    keyword_trie_insert(&keyword_trie, "else",     TOKEN_ELSE);
-    keyword_trie_insert(&keyword_trie, "if",       TOKEN_IF);
-    keyword_trie_insert(&keyword_trie, "or",       TOKEN_OR);
-    keyword_trie_insert(&keyword_trie, "super",    TOKEN_SUPER);
-    keyword_trie_insert(&keyword_trie, "mut",      TOKEN_MUT);
-
-    keyword_trie_insert(&keyword_trie, "var",      TOKEN_VAR);
-    keyword_trie_insert(&keyword_trie, "fun",      TOKEN_FUN);
-    keyword_trie_insert(&keyword_trie, "lambda",   TOKEN_LAMBDA);
-
-    keyword_trie_insert(&keyword_trie, "print",    TOKEN_PRINT);
-    keyword_trie_insert(&keyword_trie, "println",  TOKEN_PRINTLN);
-
-    keyword_trie_insert(&keyword_trie, "while",    TOKEN_WHILE);
-    keyword_trie_insert(&keyword_trie, "for",      TOKEN_FOR);
-
-    keyword_trie_insert(&keyword_trie, "return",   TOKEN_RETURN);
-    keyword_trie_insert(&keyword_trie, "break",    TOKEN_BREAK);
-    keyword_trie_insert(&keyword_trie, "continue", TOKEN_CONTINUE);
-
-    keyword_trie_insert(&keyword_trie, "nil",      TOKEN_NIL);
-    keyword_trie_insert(&keyword_trie, "true",     TOKEN_TRUE);
-    keyword_trie_insert(&keyword_trie, "false",    TOKEN_FALSE);
-}
-
-static void free_keyword_trie() {
-    keyword_trie_free(&keyword_trie);
+    for (int i = 0; is_alpha(peek()) || is_digit(peek()); i++) {
+        if (i == SCAN_SHORT_RUN) {
+            scanner.current = simd_skip_identifier(scanner.current);
+            break;
+        }
+        advance();
+    }
+    token_t token = make_token(identifier_type());
+    // keywords are hashed too, the compiler names functions after tokens such as 'lambda'
+    token.hash = hash_bytes(token.start, token.length);
+    return token;
 }
 
+/*
+ * The keyword table is constant, the scanner needs no setup or teardown.
+ * Both are kept as the interpreter's launch and shutdown hooks.
+ */
 void launch_scanner() {
-    init_keyword_trie();
 }
 
 void free_scanner() {
-    free_keyword_trie();
 }
 
 void init_scanner(const char* source) {
@@ -203,6 +180,7 @@ token_t scan_token() {
         case '}': return make_token(TOKEN_RIGHT_BRACE);
         case ';': return make_token(TOKEN_SEMICOLON);
         case ',': return make_token(TOKEN_COMMA);
+        case ':': return make_token(TOKEN_COLON);
         case '.': return make_token(TOKEN_DOT);
         case '-': return make_token(TOKEN_MINUS);
         case '+': return make_token(TOKEN_PLUS);
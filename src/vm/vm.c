@@ -1,11 +1,13 @@
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "common.h"
 #include "constant.h"
-#include "switch.h"
 
 #include "component/vartable.h"
 #include "component/valuetable.h"
@@ -16,19 +18,18 @@
 
 #ifdef DEBUG_PRINT_CODE
 #include "debug/debug.h"
-#include "switch.h"
 #include "component/valuetable.h"
 
 #endif
 
-vm_t vm;
+_Thread_local vm_t* vm = NULL;
 
 #ifdef DEBUG_VM_MEMORY
 static void print_vm_structure() {
     printf("----------------------------------\n");
     // print var tables
-    for (int i = 0; i < vm.globals.capacity; ++i) {
-        table_entry_t *entry = &vm.globals.entries[i];
+    for (int i = 0; i < vm->globals.capacity; ++i) {
+        table_entry_t *entry = &vm->globals.entries[i];
         if (entry->key == NULL) continue;
         printf("table item %p, key ", entry);
         print_value(OBJECT_VAL(entry->key));
@@ -44,8 +45,8 @@ static void print_vm_structure() {
     // print interned strings
 #ifdef DEBUG_PRINT_STRINGS
     printf("\nstrings\n");
-    for (int i = 0; i < vm.strings.capacity; ++i) {
-        table_entry_t *entry = &vm.strings.entries[i];
+    for (int i = 0; i < vm->strings.capacity; ++i) {
+        table_entry_t *entry = &vm->strings.entries[i];
         if (entry->key == NULL) continue;
         print_value(OBJECT_VAL(entry->key));
         printf("\n");
@@ -56,7 +57,7 @@ static void print_vm_structure() {
     // print objects
 #ifdef DEBUG_PRINT_OBJCTS
     object_t* iter = NULL;
-    list_iterate_begin(object_t, link, &vm.obj, iter) {
+    list_iterate_begin(object_t, link, &vm->obj, iter) {
         printf("object %p, type ", iter);
         switch (iter->type) {
             case OBJ_STRING:
@@ -84,21 +85,76 @@ static void print_vm_structure() {
 }
 #endif
 
-static void reset_stack() {
-    vm.stack_top = vm.stack;
-    vm.frame_count = 0;
-    list_init(&vm.open_upvalues);
+static void close_upvalues(value_t* last);
+
+// parks the running call stack in its owner, the running fiber or the root
+static void save_call_stack() {
+    call_stack_t* stack = vm->fiber != NULL ? &vm->fiber->stack : &vm->root;
+    stack->frame_count = vm->frame_count;
+    stack->stack_top = vm->stack_top;
+    // growing the running call stack may have moved it
+    stack->frames = vm->frames;
+    stack->frame_capacity = vm->frame_capacity;
+    stack->stack = vm->stack;
+    stack->stack_capacity = vm->stack_capacity;
+    stack->frame_base = vm->frame_base;
 }
 
-static void runtime_error(const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    vfprintf(stderr, format, args);
-    va_end(args);
-    fputs("\n", stderr);
+// makes the call stack of 'fiber' the running one, the root call stack for NULL
+static void load_call_stack(object_fiber_t* fiber) {
+    call_stack_t* stack = fiber != NULL ? &fiber->stack : &vm->root;
+    vm->fiber = fiber;
+    vm->frames = stack->frames;
+    vm->frame_count = stack->frame_count;
+    vm->frame_capacity = stack->frame_capacity;
+    vm->stack = stack->stack;
+    vm->stack_top = stack->stack_top;
+    vm->stack_capacity = stack->stack_capacity;
+    vm->frame_base = stack->frame_base;
+    vm->open_upvalues = &stack->open_upvalues;
+}
+
+/*
+ *  Ends the running fiber and switches back to the one that resumed it.
+ *  Its call stack is released right away, closures still reaching into it get their values first.
+ */
+static void finish_fiber() {
+    object_fiber_t* fiber = vm->fiber;
+    close_upvalues(vm->stack);
+    fiber->state = FIBER_DONE;
+    free_call_stack(&fiber->stack);
+    load_call_stack(fiber->caller);
+    fiber->caller = NULL;
+}
 
-    for (int i = vm.frame_count - 1; i >= 0; --i) {
-        callframe_t* frame = &vm.frames[i];
+// stops the running fiber in 'state' and hands 'value' to the call stack that resumed it
+static void suspend_fiber(fiber_state_t state, value_t value) {
+    object_fiber_t* fiber = vm->fiber;
+    save_call_stack();
+    fiber->state = state;
+    load_call_stack(fiber->caller);
+    fiber->caller = NULL;
+    push(value);
+}
+
+static void reset_stack() {
+    // a runtime error inside fibers unwinds all of them down to the root call stack
+    while (vm->fiber != NULL)
+        finish_fiber();
+    vm->stack_top = vm->stack;
+    vm->frame_count = 0;
+    vm->frame_base = 0;
+    list_init(vm->open_upvalues);
+}
+
+static void print_stack_trace(callframe_t* frames, int frame_count) {
+    for (int i = frame_count - 1; i >= 0; --i) {
+        // deep recursion only shows the innermost and the outermost frames
+        if (i == frame_count - 1 - STACK_TRACE_FRAMES && i >= STACK_TRACE_FRAMES) {
+            fprintf(stderr, "... %d more frames\n", i - STACK_TRACE_FRAMES + 1);
+            i = STACK_TRACE_FRAMES - 1;
+        }
+        callframe_t* frame = &frames[i];
         object_function_t* func = frame->closure->function;
         size_t instruction = frame->ip - func->chunk.code - 1;
         fprintf(stderr, "[line %d] in ", func->chunk.lines[instruction]);
@@ -108,12 +164,31 @@ static void runtime_error(const char* format, ...) {
             fprintf(stderr, "%s()\n", func->name->chars);
         }
     }
+}
+
+// cold keeps the error path from shaping how run() is laid out
+__attribute__((cold)) static void runtime_error(const char* format, ...) {
+    // what was printed before comes first
+    flush_output(&vm->output);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputs("\n", stderr);
+
+    // the running call stack first, then those of the fibers waiting on it
+    print_stack_trace(vm->frames, vm->frame_count);
+    if (vm->fiber != NULL) {
+        for (object_fiber_t* fiber = vm->fiber->caller; fiber != NULL; fiber = fiber->caller)
+            print_stack_trace(fiber->stack.frames, fiber->stack.frame_count);
+        print_stack_trace(vm->root.frames, vm->root.frame_count);
+    }
 
     reset_stack();
 }
 
 static value_t peek(int distance) {
-    return vm.stack_top[-1 - distance];
+    return vm->stack_top[-1 - distance];
 }
 
 static bool is_falsy(value_t value) {
@@ -123,9 +198,19 @@ static bool is_falsy(value_t value) {
 }
 
 static void free_objects() {
-    while(!list_empty(&vm.obj)) {
-        list_remove_head(&vm.obj);
-    }
+    merge_temporary();
+    object_t* iter = NULL;
+    list_iterate_begin(object_t, link, &vm->obj, iter) {
+        list_remove(&iter->link);
+        free_object(iter);
+    } list_iterate_end();
+}
+
+// makes room for one more frame and 'slots' values above the stack top, the stack may move
+static __attribute__((cold)) void grow_stack(int slots) {
+    save_call_stack();
+    grow_call_stack(vm->fiber != NULL ? &vm->fiber->stack : &vm->root, slots);
+    load_call_stack(vm->fiber);
 }
 
 static bool call(object_closure_t * closure, int arg_count) {
@@ -135,23 +220,25 @@ static bool call(object_closure_t * closure, int arg_count) {
         return false;
     }
 
-    if (vm.frame_count == FRAMES_MAX) {
+    if (vm->frame_count == vm->frames_max) {
         __CLOX_RUNTIME_ERROR("Stack overflow.");
         return false;
     }
+    // the frame starts at the callee, which has counted its slots already
+    int slots = closure->function->max_slots - arg_count - 1 + FRAME_SLOTS;
+    if (vm->frame_count == vm->frame_capacity || vm->stack_top + slots > vm->stack + vm->stack_capacity)
+        grow_stack(slots);
 
-    callframe_t* frame = &vm.frames[vm.frame_count++];
+    callframe_t* frame = &vm->frames[vm->frame_count++];
     frame->closure = closure;
     frame->ip = closure->function->chunk.code;
-    int bias = ((vm.stack_top - arg_count - 1) - vm.stack);
-    frame->slots = vm.stack_top - arg_count - 1;
-    frame->local_meta = &vm.local[bias];
+    frame->slots = vm->stack_top - arg_count - 1;
     return true;
 }
 
-static object_upvalue_t* capture_upvalue(value_t* local, var_metadata_t* local_meta) {
+static object_upvalue_t* capture_upvalue(value_t* local) {
     object_upvalue_t* iter = NULL;
-    list_iterate_begin(object_upvalue_t, link, &vm.open_upvalues, iter) {
+    list_iterate_begin(object_upvalue_t, link, vm->open_upvalues, iter) {
         if (iter->location < local)
             goto STOP_LOOP;
         if (iter->location == local)
@@ -160,21 +247,22 @@ static object_upvalue_t* capture_upvalue(value_t* local, var_metadata_t* local_m
     STOP_LOOP:;
 
     object_upvalue_t* created_upvalue = new_upvalue(local);
-    created_upvalue->mutable = local_meta->mutable;
+    created_upvalue->fiber = vm->fiber;
     if (iter == NULL)
-        list_insert_head(&vm.open_upvalues, &created_upvalue->link);
+        list_insert_head(vm->open_upvalues, &created_upvalue->link);
     else
         list_insert_after(iter->link.l_prev, &created_upvalue->link);
     return created_upvalue;
 }
 
 static void close_upvalues(value_t* last) {
-    while (!list_empty(&vm.open_upvalues)) {
-        object_upvalue_t* iter = list_head_item(object_upvalue_t, link, &vm.open_upvalues);
+    while (!list_empty(vm->open_upvalues)) {
+        object_upvalue_t* iter = list_head_item(object_upvalue_t, link, vm->open_upvalues);
         if (iter->location < last) break;
         iter->closed = *iter->location;
         iter->location = &iter->closed;
-        list_remove_head(&vm.open_upvalues);
+        iter->fiber = NULL;
+        list_remove_head(vm->open_upvalues);
     }
 }
 
@@ -183,16 +271,14 @@ static bool call_value(value_t callee, int arg_count) {
         switch (OBJ_TYPE(callee)) {
             case OBJ_BOUND_METHOD: {
                 object_bound_method_t *bound = AS_BOUND_METHOD(callee);
-                vm.stack_top[-arg_count - 1] = bound->receiver;
+                vm->stack_top[-arg_count - 1] = bound->receiver;
                 return call(bound->method, arg_count);
             }
             case OBJ_CLASS: {
                 object_class_t *klass = AS_CLASS(callee);
-                vm.stack_top[-arg_count - 1] = OBJECT_VAL(new_instance(klass));
-                value_t init;
-
-                if (table_get_value(&klass->methods, vm.init_string, &init)) {
-                    return call(AS_CLOSURE(init), arg_count);
+                vm->stack_top[-arg_count - 1] = OBJECT_VAL(new_instance(klass));
+                if (klass->initializer != NULL) {
+                    return call(klass->initializer, arg_count);
                 }
 
                 return true;
@@ -208,9 +294,23 @@ static bool call_value(value_t callee, int arg_count) {
                     __CLOX_RUNTIME_ERROR("Expect %d arguments, but found %d.", arity, arg_count);
                     return false;
                 }
+                // natives only ever see flat strings
+                for (value_t* arg = vm->stack_top - arg_count; arg < vm->stack_top; arg++)
+                    *arg = flatten_value(*arg);
                 native_fn_t f = native->function;
-                value_t result = f(arg_count, vm.stack_top - arg_count);
-                vm.stack_top -= arg_count + 1;
+                value_t result = f(arg_count, vm->stack_top - arg_count);
+                if (IS_NONE(result)) {
+                    // without a message a call the native made failed, and its error is reported already
+                    if (vm->native_error[0] != '\0')
+                        __CLOX_RUNTIME_ERROR("%s", vm->native_error);
+                    return false;
+                }
+                vm->stack_top -= arg_count + 1;
+                // the native parked the running task, the event loop resumes it with the actual result
+                if (vm->fiber != NULL && vm->fiber->state == FIBER_WAITING) {
+                    suspend_fiber(FIBER_WAITING, NIL_VAL);
+                    return true;
+                }
                 push(result);
                 return true;
             }
@@ -222,16 +322,33 @@ static bool call_value(value_t callee, int arg_count) {
     return false;
 }
 
-static bool invoke_from_class(object_class_t *klass, object_string_t *name, int arg_count) {
-    value_t method;
-    if(!table_get_value(&klass->methods, name, &method)) {
-        runtime_error("Undefined property '%s'.", name->chars);
-        return false;
+/*
+ * 'hint' is the cache operand of the invoking instruction, the slot the method was found in last time.
+ * Subclasses keep the slots of inherited methods, so a hint usually holds for a whole hierarchy.
+ * Checking the name in that slot is all it takes to trust it.
+ */
+static int find_method_slot(object_class_t *klass, object_string_t *name, uint8_t *hint) {
+    int slot = *hint;
+    if (slot >= klass->method_count || klass->vtable[slot].name != name) {
+        slot = class_find_method(klass, name);
+        if (slot < 0) {
+            runtime_error("Undefined property '%s'.", name->chars);
+            return -1;
+        }
+        if (slot < INVOKE_NO_HINT)
+            *hint = (uint8_t)slot;
     }
-    return call(AS_CLOSURE(method), arg_count);
+    return slot;
 }
 
-static bool invoke(object_string_t* name, int arg_count) {
+static bool invoke_from_class(object_class_t *klass, object_string_t *name, int arg_count, uint8_t *hint) {
+    int slot = find_method_slot(klass, name, hint);
+    if (slot < 0)
+        return false;
+    return call(klass->vtable[slot].method, arg_count);
+}
+
+static bool invoke(object_string_t* name, int arg_count, uint8_t *hint) {
     value_t receiver = peek(arg_count);
 
     if (!IS_INSTANCE(receiver)) {
@@ -242,37 +359,273 @@ static bool invoke(object_string_t* name, int arg_count) {
     object_instance_t *instance = AS_INSTANCE(receiver);
 
     value_t value;
-    if (table_get_value(&instance->fields, name, &value)) {
-        vm.stack_top[-arg_count - 1] = value;
+    if (name->field_name && table_get_value(&instance->fields, name, &value)) {
+        vm->stack_top[-arg_count - 1] = value;
         return call_value(value, arg_count);
     }
 
-    return invoke_from_class(instance->klass, name, arg_count);
+    return invoke_from_class(instance->klass, name, arg_count, hint);
+}
+
+/*
+ * Calls 'callee' in place of the running frame, the result of the call is the result of that frame.
+ * It stays out of line, inlined twice into run() it slows down every other opcode.
+ */
+static __attribute__((noinline)) bool tail_call(value_t callee, int arg_count) {
+    if (IS_BOUND_METHOD(callee)) {
+        vm->stack_top[-arg_count - 1] = AS_BOUND_METHOD(callee)->receiver;
+        callee = OBJECT_VAL(AS_BOUND_METHOD(callee)->method);
+    }
+    // natives and classes are called as usual, the OP_RETURN behind returns their result
+    if (!IS_CLOSURE(callee))
+        return call_value(callee, arg_count);
+
+    object_closure_t* closure = AS_CLOSURE(callee);
+    if (arg_count != closure->function->arity) {
+        runtime_error("Expected %d arguments but got %d.", closure->function->arity, arg_count);
+        return false;
+    }
+    // the callee and its arguments slide down over the returning frame, which runs the callee from the start
+    callframe_t* frame = &vm->frames[vm->frame_count - 1];
+    close_upvalues(frame->slots);
+    memmove(frame->slots, vm->stack_top - arg_count - 1, sizeof(value_t) * (arg_count + 1));
+    vm->stack_top = frame->slots + arg_count + 1;
+    int slots = closure->function->max_slots - arg_count - 1 + FRAME_SLOTS;
+    if (vm->stack_top + slots > vm->stack + vm->stack_capacity) {
+        grow_stack(slots);
+        frame = &vm->frames[vm->frame_count - 1];
+    }
+    frame->closure = closure;
+    frame->ip = closure->function->chunk.code;
+    return true;
+}
+
+static __attribute__((noinline)) bool tail_invoke(object_string_t* name, int arg_count, uint8_t *hint) {
+    value_t receiver = peek(arg_count);
+
+    if (!IS_INSTANCE(receiver)) {
+        runtime_error("Only instances have methods.");
+        return false;
+    }
+
+    object_instance_t *instance = AS_INSTANCE(receiver);
+
+    value_t value;
+    if (name->field_name && table_get_value(&instance->fields, name, &value)) {
+        vm->stack_top[-arg_count - 1] = value;
+        return tail_call(value, arg_count);
+    }
+
+    int slot = find_method_slot(instance->klass, name, hint);
+    if (slot < 0)
+        return false;
+    return tail_call(OBJECT_VAL(instance->klass->vtable[slot].method), arg_count);
 }
 
 static void define_method(object_string_t *name) {
-    value_t method = peek(0);
+    object_closure_t *method = AS_CLOSURE(peek(0));
     object_class_t *klass = AS_CLASS(peek(1));
-    table_set_value(&klass->methods, name, method);
+    class_define_method(klass, name, method);
     pop();
 }
 
 static bool bind_method(object_class_t *klass, object_string_t *name) {
-    value_t method;
-    if (!table_get_value(&klass->methods, name, &method)) {
+    int slot = class_find_method(klass, name);
+    if (slot < 0) {
         runtime_error("Undefined property '%s'.", name->chars);
         return false;
     }
 
-    object_bound_method_t *bound = new_bound_method(peek(0), AS_CLOSURE(method));
+    object_bound_method_t *bound = new_bound_method(peek(0), klass->vtable[slot].method);
     pop();
     push(OBJECT_VAL(bound));
     return true;
 }
 
+static bool get_global(table_t* globals, object_string_t* name, var_t* var) {
+    return table_get_var(globals, name, var) || table_get_var(&vm->globals, name, var);
+}
+
+/*
+ * Pushes the module and the result of its top level code, OP_IMPORT_BIND pops both.
+ * A module seen before is taken from vm->modules, otherwise it is compiled and a frame running it is pushed.
+ */
+static bool import_module(object_module_t* importer, object_string_t* name) {
+    object_string_t* path = resolve_module_path(importer, name);
+    if (path == NULL) {
+        __CLOX_RUNTIME_ERROR("Could not open module '%s'.", name->chars);
+        return false;
+    }
+    push(OBJECT_VAL(path));
+
+    value_t cached;
+    if (table_get_value(&vm->modules, path, &cached)) {
+        pop();
+        if (!AS_MODULE(cached)->loaded) {
+            __CLOX_RUNTIME_ERROR("Circular import of module '%s'.", name->chars);
+            return false;
+        }
+        push(cached);
+        push(NIL_VAL);
+        return true;
+    }
+
+    char* source = read_module_source(path->chars);
+    if (source == NULL) {
+        __CLOX_RUNTIME_ERROR("Could not read module '%s'.", name->chars);
+        return false;
+    }
+    object_module_t* module = new_module(path);
+    vm->stack_top[-1] = OBJECT_VAL(module);
+    table_set_value(&vm->modules, path, OBJECT_VAL(module));
+
+    object_function_t* func = compile(source, module);
+    free(source);
+    if (func == NULL) {
+        table_delete_value(&vm->modules, path);
+        __CLOX_RUNTIME_ERROR("Could not compile module '%s'.", name->chars);
+        return false;
+    }
+    push(OBJECT_VAL(func));
+    object_closure_t* closure = new_closure(func);
+    pop();
+    push(OBJECT_VAL(closure));
+    return call(closure, 0);
+}
+
+/*
+ * A runtime error abandons the modules still being imported, drop them so importing them again starts over.
+ */
+/*
+ * Binds an immutable snapshot of every global 'module' defines itself into 'importer', or fails without binding any
+ * when a name is already a global of the importer. Binding the same value again, as importing a module twice does, is no collision.
+ */
+__attribute__((cold)) static bool bind_module(object_module_t* importer, object_module_t* module) {
+    table_t* from = &module->globals;
+    for (int i = 0; i < from->capacity; i++) {
+        table_entry_t* entry = &from->entries[i];
+        if (entry->key == NULL || IS_ENTRY_NULL(entry->value) || ((var_t*)entry->value)->imported)
+            continue;
+        var_t* existing = table_find_var(&importer->globals, entry->key);
+        if (existing != NULL && !(existing->imported && values_equal(existing->v, ((var_t*)entry->value)->v))) {
+            __CLOX_RUNTIME_ERROR("Module '%s' defines '%s', which is already a global.", module->path->chars, entry->key->chars);
+            return false;
+        }
+    }
+    for (int i = 0; i < from->capacity; i++) {
+        table_entry_t* entry = &from->entries[i];
+        if (entry->key == NULL || IS_ENTRY_NULL(entry->value) || ((var_t*)entry->value)->imported)
+            continue;
+        define_global(importer, entry->key, ((var_t*)entry->value)->v, false);
+        table_find_var(&importer->globals, entry->key)->imported = true;
+    }
+    return true;
+}
+
+static void forget_unloaded_modules() {
+    for (int i = 0; i < vm->modules.capacity; i++) {
+        table_entry_t* entry = &vm->modules.entries[i];
+        if (entry->key == NULL || IS_ENTRY_NULL(entry->value))
+            continue;
+        object_module_t* module = AS_MODULE(*(value_t*)entry->value);
+        if (!module->loaded && module != vm->main)
+            table_delete_value(&vm->modules, entry->key);
+    }
+}
+
+/*
+ *  Switches to the call stack of 'fiber', the running call stack waits for it to yield or return.
+ *  A new fiber calls its function with 'value' as the argument, a suspended one gets it as the result of its yield.
+ */
+static bool resume_fiber(object_fiber_t* fiber, value_t value) {
+    if (fiber->state == FIBER_RUNNING) {
+        __CLOX_RUNTIME_ERROR("Cannot resume a running fiber.");
+        return false;
+    }
+    if (fiber->state == FIBER_DONE) {
+        __CLOX_RUNTIME_ERROR("Cannot resume a finished fiber.");
+        return false;
+    }
+
+    save_call_stack();
+    fiber->caller = vm->fiber;
+    if (fiber->state == FIBER_NEW) {
+        init_call_stack(&fiber->stack);
+        load_call_stack(fiber);
+        fiber->state = FIBER_RUNNING;
+        int arg_count = fiber->closure->function->arity;
+        push(OBJECT_VAL(fiber->closure));
+        if (arg_count)
+            push(value);
+        return call(fiber->closure, arg_count);
+    }
+    load_call_stack(fiber);
+    fiber->state = FIBER_RUNNING;
+    push(value);
+    return true;
+}
+
+/*
+ * Map operations on the values at the top of the stack, false if a key cannot be a map key.
+ * Marked cold so they stay out of run() and the list and array paths next to them compile as before,
+ * the call costs a map access next to nothing.
+ */
+static __attribute__((cold)) bool get_map_index() {
+    value_t key, value;
+    if (!map_key(peek(0), &key))
+        return false;
+    // a missing key reads as nil
+    if (!map_get(AS_MAP(peek(1)), key, &value))
+        value = NIL_VAL;
+    vm->stack_top -= 2;
+    push(value);
+    return true;
+}
+
+static __attribute__((cold)) bool set_map_index() {
+    value_t key;
+    if (!map_key(peek(1), &key))
+        return false;
+    map_set(AS_MAP(peek(2)), key, peek(0));
+    value_t value = pop();
+    vm->stack_top -= 2;
+    push(value);
+    return true;
+}
+
+// the keys and values of 'count' entries alternate on the stack
+static __attribute__((cold)) bool build_map(int count) {
+    object_map_t* map = new_map(count);
+    value_t* entries = vm->stack_top - 2 * count;
+    for (int i = 0; i < count; i++) {
+        value_t key;
+        if (!map_key(entries[2 * i], &key))
+            return false;
+        map_set(map, key, entries[2 * i + 1]);
+    }
+    vm->stack_top = entries;
+    push(OBJECT_VAL(map));
+    return true;
+}
+
+/*
+ * The module has defined a global named like the intrinsic since the code was compiled:
+ * the global goes below the arguments and is called as if the code had not been lowered.
+ * The callee takes one more slot than the compiler counted, the room natives have covers it.
+ */
+static __attribute__((cold)) bool call_shadowing_global(object_module_t* module, int intrinsic, int arg_count) {
+    const char* name = intrinsic_name(intrinsic);
+    var_t global;
+    table_get_var(&module->globals, copy_string(name, (int)strlen(name)), &global);
+    memmove(vm->stack_top - arg_count + 1, vm->stack_top - arg_count, sizeof(value_t) * arg_count);
+    vm->stack_top++;
+    vm->stack_top[-arg_count - 1] = global.v;
+    return call_value(global.v, arg_count);
+}
+
 static interpret_result_t run() {
 
-    callframe_t* frame = &vm.frames[vm.frame_count - 1];
+    callframe_t* frame = &vm->frames[vm->frame_count - 1];
     register uint8_t *ip = frame->ip;
 
 #define CONTEXT_SWITCH(to)        \
@@ -282,12 +635,27 @@ static interpret_result_t run() {
         frame = (to);             \
     } while(0)
 
+// calls may move the frames while growing the call stack, the running one is looked up again
+#define LOAD_FRAME()                              \
+    do {                                          \
+        frame = &vm->frames[vm->frame_count - 1]; \
+        ip = frame->ip;                           \
+    } while(0)
+
+// the stack trace reads the ip of every frame, the running one keeps its own in 'ip'
+#define runtime_error(...)        \
+    do {                          \
+        frame->ip = ip;           \
+        runtime_error(__VA_ARGS__); \
+    } while(0)
+
 #define READ_BYTE() (*ip++)
 #define READ_SHORT() (ip += 2, (uint16_t)((ip[-2] << 8) | ip[-1]))
 #define READ_CONSTANT() (frame->closure->function->chunk.constants.values[READ_BYTE()])
 #define READ_CONSTANT_LONG() (frame->closure->function->chunk.constants.values[READ_SHORT()])
 #define READ_STRING() (AS_STRING(READ_CONSTANT()))
 #define READ_STRING_LONG()  (AS_STRING(READ_CONSTANT_LONG()))
+#define GLOBALS() (&frame->closure->function->module->globals)
 #define BINARY_OP(value_type, op) \
     do {  \
         if (!IS_NUMBER(peek(0)) || !IS_NUMBER(peek(1))) { \
@@ -300,8 +668,18 @@ static interpret_result_t run() {
     } while (0)
 #define ADD_OP \
     do { \
+        if (is_string_like(peek(0)) && is_string_like(peek(1))) { \
+            value_t result = concatenate(peek(1), peek(0)); \
+            if (IS_NONE(result)) { \
+                runtime_error("String length cannot exceed %d.", STRING_LENGTH_MAX); \
+                return INTERPRET_RUNTIME_ERROR; \
+            } \
+            vm->stack_top -= 2; \
+            push(result); \
+            break; \
+        } \
         if (!IS_NUMBER(peek(0)) || !IS_NUMBER(peek(1))) { \
-            runtime_error("Operands must be numbers."); \
+            runtime_error("Operands must be two numbers or two strings."); \
             return INTERPRET_RUNTIME_ERROR; \
         } \
         value_t b = pop(); \
@@ -354,6 +732,31 @@ static interpret_result_t run() {
         } \
         push(__float_div(a, b)); \
     } while (0)
+/*
+ * Intrinsics skip the global lookup and the call: the native runs on the arguments where they are
+ * and its result replaces them. The compiler only lowers natives that accept ropes as they are.
+ * Globals are bound late, a global of the same name defined after the code was compiled is called instead.
+ */
+#define INTRINSIC(native, argc) \
+    do { \
+        object_module_t* module = frame->closure->function->module; \
+        if (module->shadowed_intrinsics & (1u << (instruction - OP_SQRT))) { \
+            frame->ip = ip; \
+            if (!call_shadowing_global(module, instruction - OP_SQRT, argc)) \
+                return INTERPRET_RUNTIME_ERROR; \
+            if (vm->frame_count == vm->frame_base) \
+                return INTERPRET_OK; \
+            LOAD_FRAME(); \
+            break; \
+        } \
+        value_t result = native(argc, vm->stack_top - (argc)); \
+        if (IS_NONE(result)) { \
+            runtime_error("%s", vm->native_error); \
+            return INTERPRET_RUNTIME_ERROR; \
+        } \
+        vm->stack_top -= (argc) - 1; \
+        vm->stack_top[-1] = result; \
+    } while (0)
 #define INTEGER_BINARY_OP(op_method) \
     do { \
         if (!IS_INT(peek(0)) || !IS_INT(peek(1))) { \
@@ -370,8 +773,9 @@ static interpret_result_t run() {
     for(;;) {
 
 #ifdef DEBUG_TRACE_EXECUTION
+    flush_output(&vm->output);
     int printed = 0;
-    for (value_t* slot = vm.stack; slot < vm.stack_top; slot++) {
+    for (value_t* slot = vm->stack; slot < vm->stack_top; slot++) {
         printf("[ ");
         printed += printf(" %p ", slot);
         printed += print_value(*slot) + 4;
@@ -407,10 +811,19 @@ static interpret_result_t run() {
             case OP_MOD:           INTEGER_BINARY_OP(__integer_mod);   break;
             case OP_LEFT_SHIFT:    INTEGER_BINARY_OP(__integer_lsh);   break;
             case OP_RIGHT_SHIFT:   INTEGER_BINARY_OP(__integer_rsh);   break;
+            case OP_SQRT:          INTRINSIC(sqrt_native,  1);         break;
+            case OP_FLOOR:         INTRINSIC(floor_native, 1);         break;
+            case OP_ABS:           INTRINSIC(abs_native,   1);         break;
+            case OP_MIN:           INTRINSIC(min_native,   2);         break;
+            case OP_MAX:           INTRINSIC(max_native,   2);         break;
+            case OP_POW:           INTRINSIC(pow_native,   2);         break;
+            case OP_LEN:           INTRINSIC(len_native,   1);         break;
+            case OP_TYPE:          INTRINSIC(type_native,  1);         break;
             case OP_EQUAL: {
-                value_t a = pop();
-                value_t b = pop();
-                push(BOOL_VAL(values_equal(a, b)));
+                // compare before popping, flattening a rope may allocate
+                bool equal = values_equal(peek(0), peek(1));
+                vm->stack_top -= 2;
+                push(BOOL_VAL(equal));
                 break;
             }
             case OP_NOT:
@@ -433,26 +846,38 @@ static interpret_result_t run() {
                 */
                 value_t value = pop();
                 close_upvalues(frame->slots);
-                vm.frame_count--;
-                if (vm.frame_count == 0) {
-                    pop();
-                    return INTERPRET_OK;
+                vm->frame_count--;
+                vm->stack_top = frame->slots;
+                if (vm->frame_count == 0 && vm->fiber != NULL) {
+                    // the fiber's function returned, its resumer gets the value
+                    finish_fiber();
+                    push(value);
+                    // a finished task hands control back to the event loop
+                    if (vm->frame_count == vm->frame_base)
+                        return INTERPRET_OK;
+                    LOAD_FRAME();
+                    break;
                 }
-                vm.stack_top = frame->slots;
                 push(value);
-                CONTEXT_SWITCH(&vm.frames[vm.frame_count - 1]);
+                // the returned value is left on the stack for interpret_call()
+                if (vm->frame_count == vm->frame_base)
+                    return INTERPRET_OK;
+                CONTEXT_SWITCH(&vm->frames[vm->frame_count - 1]);
                 break;
             }
             case OP_NIL:   push(NIL_VAL); break;
             case OP_TRUE:  push(BOOL_VAL(1)); break;
             case OP_FALSE: push(BOOL_VAL(0)); break;
             case OP_PRINT: {
-                print_value(pop());
+                // printing a rope flattens it, keep it reachable until done
+                write_value(&vm->output, peek(0));
+                pop();
                 break;
             }
             case OP_PRINTLN: {
-                print_value(pop());
-                printf("\n");
+                write_value(&vm->output, peek(0));
+                pop();
+                output_write(&vm->output, "\n", 1);
                 break;
             }
             case OP_POP: {
@@ -461,37 +886,37 @@ static interpret_result_t run() {
             }
             case OP_POPN: {
                 uint8_t stacks_to_pop = READ_BYTE();
-                vm.stack_top -= stacks_to_pop;
+                vm->stack_top -= stacks_to_pop;
                 break;
             }
             case OP_DEFINE_GLOBAL: {
                 object_string_t* name = READ_STRING();
-                table_set_var(&vm.globals, name, (var_t) {false, peek(0)});
+                define_global(frame->closure->function->module, name, peek(0), false);
                 pop();
                 break;
             }
             case OP_DEFINE_GLOBAL_LONG: {
                 object_string_t* name = READ_STRING_LONG();
-                table_set_var(&vm.globals, name, (var_t) {false, peek(0)});
+                define_global(frame->closure->function->module, name, peek(0), false);
                 pop();
                 break;
             }
             case OP_DEFINE_MUT_GLOBAL: {
                 object_string_t* name = READ_STRING();
-                table_set_var(&vm.globals, name, (var_t) {true , peek(0)});
+                define_global(frame->closure->function->module, name, peek(0), true);
                 pop();
                 break;
             }
             case OP_DEFINE_MUT_GLOBAL_LONG: {
                 object_string_t* name = READ_STRING_LONG();
-                table_set_var(&vm.globals, name, (var_t) {true , peek(0)});
+                define_global(frame->closure->function->module, name, peek(0), true);
                 pop();
                 break;
             }
             case OP_GET_GLOBAL: {
                 object_string_t* name = READ_STRING();
                 var_t var;
-                if (!table_get_var(&vm.globals, name, &var)) {
+                if (!get_global(GLOBALS(), name, &var)) {
                     __CLOX_RUNTIME_ERROR("Undefined variable '%s'.", name->chars);
                     return INTERPRET_RUNTIME_ERROR;
                 }
@@ -501,53 +926,34 @@ static interpret_result_t run() {
             case OP_GET_GLOBAL_LONG: {
                 object_string_t* name = READ_STRING_LONG();
                 var_t var;
-                if (!table_get_var(&vm.globals, name, &var)) {
+                if (!get_global(GLOBALS(), name, &var)) {
                     __CLOX_RUNTIME_ERROR("Undefined variable '%s'.", name->chars);
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 push(var.v);
                 break;
             }
-            case OP_SET_GLOBAL: {
-                object_string_t* name = READ_STRING();
-                var_t var;
-                if (!table_get_var(&vm.globals, name, &var)) {
+            case OP_SET_GLOBAL:
+            case OP_SET_GLOBAL_LONG: {
+                object_string_t* name = NULL;
+                if (instruction == OP_SET_GLOBAL)
+                    name = READ_STRING();
+                else
+                    name = READ_STRING_LONG();
+                // globals may be defined by code that has not run yet, they are checked here and assigned in place
+                var_t* var = table_find_var(GLOBALS(), name);
+                if (var == NULL)
+                    var = table_find_var(&vm->globals, name);
+                if (var == NULL) {
                     __CLOX_RUNTIME_ERROR("Undefined variable '%s'.", name->chars);
                     return INTERPRET_RUNTIME_ERROR;
-                } else {
-                    if (var.mutable) {
-                        table_set_var(&vm.globals, name, (var_t) {true, peek(0)});
-                    } else {
-                        __CLOX_RUNTIME_ERROR("Cannot assign new values to immutable variable '%s'.", name->chars);
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
                 }
-                break;
-            }
-            case OP_SET_GLOBAL_LONG: {
-                object_string_t* name = READ_STRING_LONG();
-                var_t var;
-                if (!table_get_var(&vm.globals, name, &var)) {
-                    __CLOX_RUNTIME_ERROR("Undefined variable '%s'.", name->chars);
+                // natives are immutable, so a mutable variable always belongs to the module
+                if (!var->mutable) {
+                    __CLOX_RUNTIME_ERROR("Cannot assign new values to immutable variable '%s'.", name->chars);
                     return INTERPRET_RUNTIME_ERROR;
-                } else {
-                    if (var.mutable) {
-                        table_set_var(&vm.globals, name, (var_t) {true, peek(0)});
-                    } else {
-                        __CLOX_RUNTIME_ERROR("Cannot assign new values to immutable variable '%s'.", name->chars);
-                        return INTERPRET_RUNTIME_ERROR;
-                    }
                 }
-                break;
-            }
-            case OP_DEFINE_LOCAL: {
-                uint8_t arg = vm.stack_top - frame->slots - 1;
-                frame->local_meta[arg].mutable = false;
-                break;
-            }
-            case OP_DEFINE_MUT_LOCAL: {
-                uint8_t arg = vm.stack_top - frame->slots - 1;
-                frame->local_meta[arg].mutable = true;
+                var->v = peek(0);
                 break;
             }
             case OP_GET_LOCAL: {
@@ -556,11 +962,8 @@ static interpret_result_t run() {
                 break;
             }
             case OP_SET_LOCAL: {
+                // the compiler only emits it for mutable locals
                 uint8_t slot = READ_BYTE();
-                if (!frame->local_meta[slot].mutable) {
-                    __CLOX_RUNTIME_ERROR("Cannot assign new values to immutable variable.");
-                    return INTERPRET_RUNTIME_ERROR;
-                }
                 frame->slots[slot] = peek(0);
                 break;
             }
@@ -579,7 +982,7 @@ static interpret_result_t run() {
                     runtime_error("Superclass must be a class.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                table_add_all(&AS_CLASS(superclass)->methods, &subclass->methods);
+                class_inherit(subclass, AS_CLASS(superclass));
                 pop();
                 break;
             }
@@ -598,6 +1001,7 @@ static interpret_result_t run() {
                     name = READ_STRING_LONG();
                 object_class_t *superclass = AS_CLASS(pop());
 
+                frame->ip = ip;
                 if (!bind_method(superclass, name))
                     return INTERPRET_RUNTIME_ERROR;
                 break;
@@ -623,6 +1027,7 @@ static interpret_result_t run() {
                     break;
                 }
 
+                frame->ip = ip;
                 if (!bind_method(instance->klass, name))
                     return INTERPRET_RUNTIME_ERROR;
                 break;
@@ -641,7 +1046,7 @@ static interpret_result_t run() {
                     name = READ_STRING_LONG();
 
                 object_instance_t *instance = AS_INSTANCE(peek(1));
-                table_set_value(&instance->fields, name, peek(0));
+                instance_set_field(instance, name, peek(0));
 
                 value_t value = pop();
                 pop(); // pop instance
@@ -649,8 +1054,15 @@ static interpret_result_t run() {
                 break;
             }
             case OP_GET_ARRAY_INDEX: {
-                if (!IS_LIST(peek(1))) {
-                    runtime_error("Only arrays have indices.");
+                if (!IS_LIST(peek(1)) && !IS_ARRAY(peek(1))) {
+                    if (IS_MAP(peek(1))) {
+                        if (!get_map_index()) {
+                            runtime_error("Map keys must be numbers, strings or booleans.");
+                            return INTERPRET_RUNTIME_ERROR;
+                        }
+                        break;
+                    }
+                    runtime_error("Only arrays and maps have indices.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 if (!IS_INT(peek(0))) {
@@ -660,7 +1072,9 @@ static interpret_result_t run() {
                 value_t index = pop();
                 value_t array = pop();
                 value_t value;
-                int result = get_list_value(AS_LIST(array), AS_INT(index), &value);
+                int result = IS_LIST(array) ?
+                        get_list_value(AS_LIST(array), AS_INT(index), &value) :
+                        get_array_value(AS_ARRAY(array), AS_INT(index), &value);
                 if (result) {
                     runtime_error("Array index out of bound.");
                     return INTERPRET_RUNTIME_ERROR;
@@ -669,8 +1083,15 @@ static interpret_result_t run() {
                 break;
             }
             case OP_SET_ARRAY_INDEX: {
-                if (!IS_LIST(peek(2))) {
-                    runtime_error("Only arrays have indices.");
+                if (!IS_LIST(peek(2)) && !IS_ARRAY(peek(2))) {
+                    if (IS_MAP(peek(2))) {
+                        if (!set_map_index()) {
+                            runtime_error("Map keys must be numbers, strings or booleans.");
+                            return INTERPRET_RUNTIME_ERROR;
+                        }
+                        break;
+                    }
+                    runtime_error("Only arrays and maps have indices.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 if (!IS_INT(peek(1))) {
@@ -680,7 +1101,14 @@ static interpret_result_t run() {
                 value_t value = pop();
                 value_t index = pop();
                 value_t array = pop();
-                int result = set_list_value(AS_LIST(array), AS_INT(index), value);
+                int result = IS_LIST(array) ?
+                        set_list_value(AS_LIST(array), AS_INT(index), value) :
+                        set_array_value(AS_ARRAY(array), AS_INT(index), value);
+                if (result == -2) {
+                    runtime_error("Cannot store this value in an array of %s.",
+                                  array_type_name(AS_ARRAY(array)->type));
+                    return INTERPRET_RUNTIME_ERROR;
+                }
                 if (result) {
                     runtime_error("Array index out of bound.");
                     return INTERPRET_RUNTIME_ERROR;
@@ -689,12 +1117,35 @@ static interpret_result_t run() {
                 break;
             }
             case OP_ARRAY: {
-                value_t init = pop();
-                value_t length = pop();
-                object_list_t *list = new_list(AS_INT(length), init);
+                if (!IS_INT(peek(1)) || AS_INT(peek(1)) < 0) {
+                    runtime_error("Array length must be a non-negative integer.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                if (AS_INT(peek(1)) > LIST_CAPACITY_MAX) {
+                    runtime_error("Array length cannot exceed %d.", LIST_CAPACITY_MAX);
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                object_list_t *list = new_list(AS_INT(peek(1)), peek(0));
+                pop();
+                pop();
                 push(OBJECT_VAL(list));
                 break;
             }
+            case OP_ARRAY_LITERAL: {
+                uint8_t count = READ_BYTE();
+                object_list_t *list = new_list(count, NIL_VAL);
+                memcpy(list->list, vm->stack_top - count, count * sizeof(value_t));
+                vm->stack_top -= count;
+                push(OBJECT_VAL(list));
+                break;
+            }
+            case OP_MAP_LITERAL: {
+                if (!build_map(READ_BYTE())) {
+                    runtime_error("Map keys must be numbers, strings or booleans.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                break;
+            }
             case OP_GET_UPVALUE: {
                 uint8_t slot = READ_BYTE();
                 push(*frame->closure->upvalues[slot]->location);
@@ -702,10 +1153,6 @@ static interpret_result_t run() {
             }
             case OP_SET_UPVALUE: {
                 uint8_t slot = READ_BYTE();
-                if (!frame->closure->upvalues[slot]->mutable) {
-                    __CLOX_RUNTIME_ERROR("Cannot assign new values to immutable variable.");
-                    return INTERPRET_RUNTIME_ERROR;
-                }
                 *frame->closure->upvalues[slot]->location = peek(0);
                 break;
             }
@@ -726,10 +1173,25 @@ static interpret_result_t run() {
             }
             case OP_CALL: {
                 int arg_count = READ_BYTE();
+                frame->ip = ip;
                 if (!call_value(peek(arg_count), arg_count)) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                CONTEXT_SWITCH(&vm.frames[vm.frame_count - 1]);
+                // a task waiting on a native hands control back to the event loop
+                if (vm->frame_count == vm->frame_base)
+                    return INTERPRET_OK;
+                LOAD_FRAME();
+                break;
+            }
+            case OP_TAIL_CALL: {
+                int arg_count = READ_BYTE();
+                frame->ip = ip;
+                if (!tail_call(peek(arg_count), arg_count)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                if (vm->frame_count == vm->frame_base)
+                    return INTERPRET_OK;
+                LOAD_FRAME();
                 break;
             }
             case OP_INVOKE:
@@ -740,10 +1202,32 @@ static interpret_result_t run() {
                 else
                     method = READ_STRING_LONG();
                 int arg_count = READ_BYTE();
-                if (!invoke(method, arg_count)) {
+                uint8_t *hint = ip++;
+                frame->ip = ip;
+                if (!invoke(method, arg_count, hint)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                if (vm->frame_count == vm->frame_base)
+                    return INTERPRET_OK;
+                LOAD_FRAME();
+                break;
+            }
+            case OP_TAIL_INVOKE:
+            case OP_TAIL_INVOKE_LONG: {
+                object_string_t *method = NULL;
+                if (instruction == OP_TAIL_INVOKE)
+                    method = READ_STRING();
+                else
+                    method = READ_STRING_LONG();
+                int arg_count = READ_BYTE();
+                uint8_t *hint = ip++;
+                frame->ip = ip;
+                if (!tail_invoke(method, arg_count, hint)) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                CONTEXT_SWITCH(&vm.frames[vm.frame_count - 1]);
+                if (vm->frame_count == vm->frame_base)
+                    return INTERPRET_OK;
+                LOAD_FRAME();
                 break;
             }
             case OP_CLOSURE: {
@@ -754,8 +1238,7 @@ static interpret_result_t run() {
                     uint8_t is_local = READ_BYTE();
                     uint8_t index = READ_BYTE();
                     if (is_local) {
-                        closure->upvalues[i] = capture_upvalue(
-                                frame->slots + index, frame->local_meta + index);
+                        closure->upvalues[i] = capture_upvalue(frame->slots + index);
                     } else {
                         closure->upvalues[i] = frame->closure->upvalues[index];
                     }
@@ -764,10 +1247,72 @@ static interpret_result_t run() {
                 break;
             }
             case OP_CLOSURE_UPVALUE: {
-                close_upvalues(vm.stack_top - 1);
+                close_upvalues(vm->stack_top - 1);
                 pop();
                 break;
             }
+            case OP_IMPORT:
+            case OP_IMPORT_LONG: {
+                object_string_t* name = NULL;
+                if (instruction == OP_IMPORT)
+                    name = READ_STRING();
+                else
+                    name = READ_STRING_LONG();
+                frame->ip = ip;
+                if (!import_module(frame->closure->function->module, name)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                LOAD_FRAME();
+                break;
+            }
+            case OP_YIELD: {
+                if (vm->fiber == NULL) {
+                    runtime_error("Cannot yield outside of a fiber.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                if (vm->frame_base > 0) {
+                    runtime_error("Cannot yield across a native call.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                value_t value = pop();
+                frame->ip = ip;
+                suspend_fiber(FIBER_SUSPENDED, value);
+                // a task yielding lets the event loop run the other tasks first
+                if (vm->frame_count == vm->frame_base)
+                    return INTERPRET_OK;
+                LOAD_FRAME();
+                break;
+            }
+            case OP_RESUME: {
+                if (!IS_FIBER(peek(1))) {
+                    runtime_error("Only fibers can be resumed.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                object_fiber_t* fiber = AS_FIBER(peek(1));
+                if (fiber->task) {
+                    runtime_error("Tasks are resumed by the event loop.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                value_t value = peek(0);
+                vm->stack_top -= 2;
+                frame->ip = ip;
+                if (!resume_fiber(fiber, value)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                LOAD_FRAME();
+                break;
+            }
+            case OP_IMPORT_BIND: {
+                // the module's top level returned nil on top of the module
+                object_module_t* module = AS_MODULE(peek(1));
+                module->loaded = true;
+                frame->ip = ip;
+                if (!bind_module(frame->closure->function->module, module)) {
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                vm->stack_top -= 2;
+                break;
+            }
             default:
                 printf("OP: %d\n", instruction);
                 __CLOX_ERROR("The clox virtual machine does not support this byte code operation.");
@@ -785,59 +1330,185 @@ static interpret_result_t run() {
     } // end for
 
 #undef INTEGER_BINARY_OP
+#undef INTRINSIC
 #undef DIV_OP
 #undef MUL_OP
 #undef SUB_OP
 #undef ADD_OP
 #undef BINARY_OP
+#undef GLOBALS
 #undef READ_STRING_LONG
 #undef READ_STRING
 #undef READ_CONSTANT_LONG
 #undef READ_CONSTANT
 #undef READ_SHORT
 #undef READ_BYTE
+#undef runtime_error
 #undef CONTEXT_SWITCH
+#undef LOAD_FRAME
 }
 
 static void define_native(const char* name, int argc, native_fn_t func) {
     push(OBJECT_VAL(copy_string(name, (int)strlen(name))));
     push(OBJECT_VAL(new_native(argc, func)));
-    table_set_var(&vm.globals, AS_STRING(vm.stack[0]), (var_t) {false, vm.stack[1]} );
+    table_set_var(&vm->globals, AS_STRING(vm->stack[0]), (var_t) {false, false, vm->stack[1]} );
     pop();
     pop();
 }
 
-void init_vm() {
+vm_t* switch_vm(vm_t* machine) {
+    vm_t* enclosing = vm;
+    vm = machine;
+    return enclosing;
+}
+
+vm_t* new_vm() {
+    vm_t* machine = ALLOCATE(vm_t, 1);
+    if (machine == NULL) {
+        __CLOX_ERROR("Not enough memory to create a virtual machine.");
+    }
+    vm_t* enclosing = switch_vm(machine);
+
     /*
-     * Initialize global vm parameters
+     * Initialize vm parameters
      */
-    do_garbage_collector = true;
-
+    vm->do_garbage_collector = true;
+
+    const char* frames_max = getenv("CLOX_FRAMES_MAX");
+    vm->frames_max = frames_max != NULL ? (int)strtol(frames_max, NULL, 10) : FRAMES_MAX;
+    if (vm->frames_max < 1)
+        vm->frames_max = FRAMES_MAX;
+    vm->objects_allocated = 0;
+    char* buffer = ALLOCATE(char, OUTPUT_BUFFER_SIZE);
+    if (buffer == NULL) {
+        __CLOX_ERROR("Not enough memory to create the output buffer.");
+    }
+    // a terminal sees every line as it is printed, pipes and files get whole buffers
+    init_output(&vm->output, stdout, buffer, OUTPUT_BUFFER_SIZE, isatty(fileno(stdout)));
+    init_call_stack(&vm->root);
+    load_call_stack(NULL);
+    init_event_loop(&vm->loop);
     reset_stack();
-    list_init(&temporary_objs);
-    list_init(&vm.obj);
-    list_init(&vm.open_upvalues);
-    init_table(&vm.globals);
-    init_table(&vm.strings);
-    init_stack(&vm.gray_stack);
-
-    vm.init_string = NULL;
-    vm.init_string = copy_string("init", 4);
+    list_init(&vm->temporary_objs);
+    list_init(&vm->obj);
+    init_table(&vm->globals);
+    init_table(&vm->modules);
+    init_table(&vm->strings);
+    init_stack(&vm->gray_stack);
+
+    vm->init_string = NULL;
+    vm->main = NULL;
+    vm->init_string = copy_string("init", 4);
+    vm->main = new_module(NULL);
 
     define_native("clock", 0, clock_native);
+    define_native("clock_ns", 0, clock_ns_native);
+    define_native("time_ns", 0, time_ns_native);
+    define_native("bench", 2, bench_native);
     define_native("type", 1, type_native);
+
+    define_native("len", 1, len_native);
+    define_native("sqrt", 1, sqrt_native);
+    define_native("floor", 1, floor_native);
+    define_native("abs", 1, abs_native);
+    define_native("min", 2, min_native);
+    define_native("max", 2, max_native);
+    define_native("pow", 2, pow_native);
+    define_native("append", 2, append_native);
+    define_native("insert", 3, insert_native);
+    define_native("pop", 1, pop_native);
+    define_native("keys", 1, keys_native);
+    define_native("has", 2, has_native);
+    define_native("remove", 2, remove_native);
+
+    define_native("int_array", 1, int_array_native);
+    define_native("float_array", 1, float_array_native);
+    define_native("byte_array", 1, byte_array_native);
+    define_native("bit_array", 1, bit_array_native);
+    define_native("array_fill", 2, array_fill_native);
+    define_native("array_sum", 1, array_sum_native);
+    define_native("array_min", 1, array_min_native);
+    define_native("array_max", 1, array_max_native);
+    define_native("array_dot", 2, array_dot_native);
+    define_native("array_add", 3, array_add_native);
+    define_native("array_sub", 3, array_sub_native);
+    define_native("array_mul", 3, array_mul_native);
+    define_native("array_div", 3, array_div_native);
+    define_native("bit_count", 1, bit_count_native);
+
+    define_native("par_sum", 1, par_sum_native);
+    define_native("par_map", 4, par_map_native);
+    define_native("par_count", 3, par_count_native);
+    define_native("par_prefix_sum", 2, par_prefix_sum_native);
+    define_native("par_histogram", 4, par_histogram_native);
+
+    define_native("channel", 0, channel_native);
+    define_native("send", 2, send_native);
+    define_native("receive", 1, receive_native);
+    define_native("spawn", 2, spawn_native);
+
+    define_native("fiber", 1, fiber_native);
+    define_native("fiber_done", 1, fiber_done_native);
+
+    define_native("task", 2, task_native);
+    define_native("sleep", 1, sleep_native);
+    define_native("read", 2, read_native);
+    define_native("write", 2, write_native);
+    define_native("flush", 0, flush_native);
+    define_native("read_file", 1, read_file_native);
+    define_native("lines", 1, lines_native);
+    define_native("read_line", 1, read_line_native);
+    define_native("open", 2, open_native);
+    define_native("close", 1, close_native);
+    define_native("pipe", 0, pipe_native);
+    define_native("listen", 1, listen_native);
+    define_native("accept", 1, accept_native);
+    define_native("connect", 2, connect_native);
+
+    switch_vm(enclosing);
+    return machine;
 }
 
-void free_vm() {
-    free_table(&vm.strings);
-    free_table_var(&vm.globals);
-    free_stack(&vm.gray_stack);
-    vm.init_string = NULL;
+void free_vm(vm_t* machine) {
+    vm_t* enclosing = switch_vm(machine);
+    free_table_value(&vm->strings);
+    free_table_var(&vm->globals);
+    free_table_value(&vm->modules);
+    vm->main = NULL;
+    free_stack(&vm->gray_stack);
+    vm->init_string = NULL;
+    free_event_loop(&vm->loop);
     free_objects();
+    free_call_stack(&vm->root);
+    flush_output(&vm->output);
+    free(vm->output.buffer);
+    free(machine);
+    switch_vm(enclosing == machine ? NULL : enclosing);
+}
+
+/*
+ *  Runs the scheduled tasks on the idle VM until none is left. Each one runs until it returns,
+ *  yields or waits, and hands control back here with its value on the root call stack.
+ */
+static interpret_result_t run_tasks() {
+    object_fiber_t* task = NULL;
+    value_t value;
+    while (loop_next(&vm->loop, &task, &value)) {
+        if (!resume_fiber(task, value))
+            return INTERPRET_RUNTIME_ERROR;
+        merge_temporary();
+        interpret_result_t result = run();
+        if (result != INTERPRET_OK)
+            return result;
+        pop();
+        if (task->state == FIBER_SUSPENDED)
+            loop_ready(&vm->loop, task, NIL_VAL);
+    }
+    return INTERPRET_OK;
 }
 
-interpret_result_t interpret(const char* source) {
-    object_function_t* func = compile(source);
+static interpret_result_t interpret_source(const char* source) {
+    object_function_t* func = compile(source, vm->main);
     if (func == NULL)
         return INTERPRET_COMPILE_ERROR;
 
@@ -849,34 +1520,123 @@ interpret_result_t interpret(const char* source) {
 
     merge_temporary();
     interpret_result_t result = run();
+    if (result == INTERPRET_RUNTIME_ERROR) {
+        forget_unloaded_modules();
+    } else {
+        pop();
+        result = run_tasks();
+    }
+    // a runtime error drops the tasks still scheduled
+    if (result == INTERPRET_RUNTIME_ERROR)
+        free_event_loop(&vm->loop);
+    flush_output(&vm->output);
     return result;
 }
 
+interpret_result_t interpret_file(vm_t* machine, const char* path, const char* source) {
+    vm_t* enclosing = switch_vm(machine);
+    object_string_t* name = copy_string(path, (int)strlen(path));
+    push(OBJECT_VAL(name));
+    object_string_t* canonical = resolve_module_path(vm->main, name);
+    pop();
+    if (canonical != NULL) {
+        vm->main->path = canonical;
+        // importing the script from one of its modules is a circular import
+        table_set_value(&vm->modules, canonical, OBJECT_VAL(vm->main));
+    }
+    interpret_result_t result = interpret_source(source);
+    switch_vm(enclosing);
+    return result;
+}
+
+interpret_result_t interpret(vm_t* machine, const char* source) {
+    vm_t* enclosing = switch_vm(machine);
+    interpret_result_t result = interpret_source(source);
+    switch_vm(enclosing);
+    return result;
+}
+
+interpret_result_t interpret_call(vm_t* machine, int arg_count) {
+    vm_t* enclosing = switch_vm(machine);
+    interpret_result_t result = INTERPRET_OK;
+    int frame_count = vm->frame_count;
+    if (!call_value(peek(arg_count), arg_count))
+        result = INTERPRET_RUNTIME_ERROR;
+    // natives return without pushing a frame
+    else if (vm->frame_count > frame_count) {
+        merge_temporary();
+        result = run();
+    }
+    if (result == INTERPRET_OK)
+        result = run_tasks();
+    if (result == INTERPRET_RUNTIME_ERROR)
+        free_event_loop(&vm->loop);
+    merge_temporary();
+    flush_output(&vm->output);
+    switch_vm(enclosing);
+    return result;
+}
+
+void define_global(object_module_t* module, object_string_t* name, value_t value, bool mutable) {
+    table_set_var(&module->globals, name, (var_t) {mutable, false, value});
+    int intrinsic = find_intrinsic(name->chars, name->length);
+    if (intrinsic >= 0)
+        module->shadowed_intrinsics |= 1u << intrinsic;
+}
+
+bool call_from_native(int arg_count) {
+    int frame_base = vm->frame_base;
+    int frame_count = vm->frame_count;
+    // run() stops where the native was called, and natives called meanwhile know they cannot park the task
+    vm->frame_base = frame_count;
+    bool success = call_value(peek(arg_count), arg_count);
+    // natives return without pushing a frame
+    if (success && vm->frame_count > frame_count) {
+        merge_temporary();
+        success = run() == INTERPRET_OK;
+    }
+    if (!success) {
+        // reported already, unwinding the stack has reset the frame base
+        vm->native_error[0] = '\0';
+        return false;
+    }
+    vm->frame_base = frame_base;
+    return true;
+}
+
+value_t native_error(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(vm->native_error, NATIVE_ERROR_MAX, format, args);
+    va_end(args);
+    return NONE_VAL;
+}
+
 void push(value_t value) {
-    *vm.stack_top = value;
-    vm.stack_top++;
+    *vm->stack_top = value;
+    vm->stack_top++;
 #ifdef DEBUG_VM_EXECUTION
-    printf("Current stack pointer %lu\n", vm.stack_top - vm.stack);
+    printf("Current stack pointer %lu\n", vm->stack_top - vm->stack);
 #endif
 }
 
 value_t pop() {
 #ifdef DEBUG_VM_EXECUTION
-    printf("Current stack pointer %lu\n", vm.stack_top - vm.stack);
+    printf("Current stack pointer %lu\n", vm->stack_top - vm->stack);
 #endif
-    vm.stack_top--;
-    return *vm.stack_top;
+    vm->stack_top--;
+    return *vm->stack_top;
 }
 
 void remove_unused_strings() {
-    table_t *table = &vm.strings;
+    table_t *table = &vm->strings;
     for (int i = 0; i < table->capacity; ++i) {
         table_entry_t *entry = &table->entries[i];
         if (entry->key && !entry->key->obj.is_marked) {
 #ifdef DEBUG_LOG_GC
             printf("Remove %s from interned strings.\n", ((object_string_t*)entry->key)->chars);
 #endif
-            table_delete(table, entry->key, NULL);
+            table_delete_value(table, entry->key);
         }
     }
 }